@@ -0,0 +1,57 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_APP_H_
+#define APP_APP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/pwm.h>
+
+/** A pin of the app-pwm-ios node and the driver serving it. */
+struct test_pwm {
+	const struct device *dev;
+	uint32_t pwm;
+	pwm_flags_t flags;
+	bool is_ic;
+};
+
+/**
+ * Drive an output pin, whichever of the PWM or IC driver owns it.
+ *
+ * @param out Output pin.
+ * @param period_usec Period in usec, 0 to stop the output.
+ * @param pulse_usec Pulse width in usec.
+ *
+ * @retval 0 If successful.
+ * @retval -ERANGE If the timings do not fit the timer.
+ * @retval -errno Other negative errno code on failure.
+ */
+int output_set(const struct test_pwm *out, uint64_t period_usec,
+	       uint64_t pulse_usec);
+
+/**
+ * Drive an output pin in its own timer cycles.
+ *
+ * @param out Output pin.
+ * @param period_cycles Period, 0 to stop the output.
+ * @param pulse_cycles Pulse width.
+ *
+ * @retval 0 If successful.
+ * @retval -errno Negative errno code on failure.
+ */
+int output_set_cycles(const struct test_pwm *out, uint32_t period_cycles,
+		      uint32_t pulse_cycles);
+
+/**
+ * Clock of an output pin, as the capture pipeline must see it.
+ *
+ * @param out Output pin.
+ *
+ * @return Output timer clock (Hz).
+ */
+uint32_t output_hz(const struct test_pwm *out);
+
+#endif /* APP_APP_H_ */
@@ -0,0 +1,202 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/pwm.h>
+#include <zephyr/shell/shell.h>
+#include <drivers/ic.h>
+
+#include "bist.h"
+
+/* Test periods, kept short to fit the startup budget. */
+static const uint32_t bist_periods_us[] = { 500, 1000, 2000 };
+
+/*
+ * Captures taken per test period: the first ones may straddle the period
+ * change of the test output or the capture start.
+ */
+#define BIST_CAPTURES 3U
+
+static struct bist_result result = { .status = -EAGAIN };
+
+static K_SEM_DEFINE(capture_sem, 0, 1);
+static volatile uint32_t captured;
+static volatile uint32_t captures;
+
+static void bist_capture_callback(const struct device *dev, uint32_t channel,
+				  uint32_t period_cycles, uint32_t pulse_cycles,
+				  int status, void *user_data)
+{
+	if (status != 0) {
+		return;
+	}
+
+	captured = period_cycles;
+	if (++captures == BIST_CAPTURES) {
+		k_sem_give(&capture_sem);
+	}
+}
+
+static int get_cycles_per_sec(const struct test_pwm *pin, uint64_t *cps)
+{
+	if (pin->is_ic) {
+		return ic_get_cycles_per_sec(pin->dev, pin->pwm, cps);
+	}
+
+	return pwm_get_cycles_per_sec(pin->dev, pin->pwm, cps);
+}
+
+static int capture_start(const struct test_pwm *in)
+{
+	ic_flags_t flags = IC_CAPTURE_MODE_CONTINUOUS | IC_CAPTURE_TYPE_PERIOD |
+			   PWM_POLARITY_NORMAL;
+	int ret;
+
+	captures = 0;
+	k_sem_reset(&capture_sem);
+
+	if (in->is_ic) {
+		ret = ic_configure_capture(in->dev, in->pwm, flags,
+					   bist_capture_callback, NULL);
+		return ret ? ret : ic_enable_capture(in->dev, in->pwm);
+	}
+
+	ret = pwm_configure_capture(in->dev, in->pwm, flags,
+				    bist_capture_callback, NULL);
+	return ret ? ret : pwm_enable_capture(in->dev, in->pwm);
+}
+
+static void capture_stop(const struct test_pwm *in)
+{
+	if (in->is_ic) {
+		ic_disable_capture(in->dev, in->pwm);
+	} else {
+		pwm_disable_capture(in->dev, in->pwm);
+	}
+}
+
+static uint32_t abs_diff(uint64_t a, uint64_t b)
+{
+	return (uint32_t)MIN(a > b ? a - b : b - a, UINT32_MAX);
+}
+
+/* Measure one test period, return -EIO if out of tolerance. */
+static int bist_check(const struct test_pwm *in, const struct test_pwm *test,
+		      uint32_t period_us, int64_t deadline)
+{
+	uint64_t in_cps, out_cps, out_cycles, expected, tolerance, usec;
+	uint32_t error;
+	int ret;
+
+	ret = get_cycles_per_sec(in, &in_cps);
+	if (ret == 0) {
+		ret = get_cycles_per_sec(test, &out_cps);
+	}
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* the output only produces whole cycles of its own timer */
+	out_cycles = (uint64_t)period_us * out_cps / USEC_PER_SEC;
+	if (out_cycles < 2U) {
+		return -ERANGE;
+	}
+	period_us = (uint32_t)(out_cycles * USEC_PER_SEC / out_cps);
+	expected = out_cycles * in_cps / out_cps;
+
+	/* set in cycles: a round trip through microseconds floors twice */
+	ret = output_set_cycles(test, (uint32_t)out_cycles,
+				(uint32_t)(out_cycles / 2U));
+	if (ret == 0) {
+		ret = capture_start(in);
+	}
+	if (ret == 0) {
+		ret = k_sem_take(&capture_sem,
+				 K_TIMEOUT_ABS_MS(deadline)) ? -ETIMEDOUT : 0;
+	}
+	capture_stop(in);
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* one input tick of quantization on top of the relative tolerance */
+	tolerance = 1U + expected * CONFIG_APP_BIST_TOLERANCE_PPM / 1000000U;
+	error = abs_diff(captured, expected);
+	result.max_error = MAX(result.max_error, error);
+	result.checked++;
+
+	if (in->is_ic) {
+		ic_cycles_to_usec(in->dev, in->pwm, expected, &usec);
+	} else {
+		pwm_cycles_to_usec(in->dev, in->pwm, expected, &usec);
+	}
+	result.max_conv_error = MAX(result.max_conv_error,
+				    abs_diff(usec, expected * USEC_PER_SEC /
+						   in_cps));
+
+	if ((error > tolerance) ||
+	    (abs_diff(usec, period_us) > 1U + period_us *
+	     CONFIG_APP_BIST_TOLERANCE_PPM / 1000000U)) {
+		result.failed++;
+		return -EIO;
+	}
+
+	return 0;
+}
+
+int bist_run(const struct test_pwm *in, const struct test_pwm *test)
+{
+	int64_t deadline = k_uptime_get() + CONFIG_APP_BIST_BUDGET_MS;
+	uint32_t start = k_cycle_get_32();
+	int ret = 0;
+
+	memset(&result, 0, sizeof(result));
+
+	for (size_t i = 0; i < ARRAY_SIZE(bist_periods_us); i++) {
+		int err = bist_check(in, test, bist_periods_us[i], deadline);
+
+		if (err == -EIO) {
+			ret = err;
+		} else if (err < 0) {
+			/* not run to completion, keep the accuracy failure */
+			ret = (ret == 0) ? err : ret;
+			break;
+		}
+	}
+
+	output_set(test, 0, 0);
+
+	result.status = ret;
+	result.duration_us = (uint32_t)k_cyc_to_us_ceil64(k_cycle_get_32() -
+							  start);
+
+	printk("BIST %s (%d): %u/%u ok, max error %u cycles, "
+	       "conversion %u us, %u us\n",
+	       ret ? "failed" : "passed", ret, result.checked - result.failed,
+	       (uint32_t)ARRAY_SIZE(bist_periods_us), result.max_error,
+	       result.max_conv_error, result.duration_us);
+
+	return ret;
+}
+
+const struct bist_result *bist_get_result(void)
+{
+	return &result;
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_bist(const struct shell *sh, size_t argc, char **argv)
+{
+	shell_print(sh, "status %d", result.status);
+	shell_print(sh, "checked %u failed %u", result.checked, result.failed);
+	shell_print(sh, "max error %u cycles, conversion %u us",
+		    result.max_error, result.max_conv_error);
+	shell_print(sh, "duration %u us", result.duration_us);
+
+	return 0;
+}
+
+SHELL_CMD_REGISTER(bist, NULL, "Power-on self-test results", cmd_bist);
+#endif
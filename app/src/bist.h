@@ -0,0 +1,46 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_BIST_H_
+#define APP_BIST_H_
+
+#include <stdint.h>
+
+#include "app.h"
+
+/** Outcome of the power-on self-test. */
+struct bist_result {
+	/** 0 if passed, -EIO on accuracy failure, other -errno if not run. */
+	int status;
+	/** Number of test periods measured. */
+	uint32_t checked;
+	/** Number of measurements out of tolerance. */
+	uint32_t failed;
+	/** Largest measured period error (input timer cycles). */
+	uint32_t max_error;
+	/** Largest conversion error of the capture driver (usec). */
+	uint32_t max_conv_error;
+	/** Time spent in the self-test (usec). */
+	uint32_t duration_us;
+};
+
+/**
+ * Run the capture accuracy self-test.
+ *
+ * Sweeps a few periods on the test output, which must be looped to the
+ * capture input, and checks the captured period and its conversion to
+ * usec. Stops early once CONFIG_APP_BIST_BUDGET_MS is spent. Capture and
+ * test output are left disabled.
+ *
+ * @param in Capture input.
+ * @param test Test output.
+ *
+ * @return Self-test status, also kept for bist_get_result().
+ */
+int bist_run(const struct test_pwm *in, const struct test_pwm *test);
+
+/** Result of the last bist_run(). */
+const struct bist_result *bist_get_result(void);
+
+#endif /* APP_BIST_H_ */
@@ -0,0 +1,285 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/fatal.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/reboot.h>
+#include <codec/period_codec.h>
+
+#include "blackbox.h"
+
+#define BB_SAMPLES CONFIG_APP_BLACKBOX_SAMPLES
+#define BB_PARTITION FIXED_PARTITION_ID(blackbox_partition)
+
+BUILD_ASSERT(IS_POWER_OF_TWO(BB_SAMPLES),
+	     "CONFIG_APP_BLACKBOX_SAMPLES must be a power of two");
+
+#define BB_RING_MAGIC 0x42425247U /* "BBRG" */
+#define BB_FLASH_MAGIC 0x42424c47U /* "BBLG" */
+#define BB_FLASH_VERSION 1U
+
+/* Flash write granularity of the STM32 C0/G0 (double word). */
+#define BB_WRITE_BLOCK 8U
+
+struct bb_sample {
+	uint32_t in;
+	uint32_t out;
+};
+
+/* RAM ring, kept across warm resets to report fatal errors. */
+struct bb_ring {
+	uint32_t magic;
+	uint32_t fault;
+	uint32_t head;
+	struct bb_sample samples[BB_SAMPLES];
+};
+
+/*
+ * Flash record header. The payload follows: for each sample from the oldest,
+ * the input then the output period, each an include/codec/period_codec.h
+ * stream starting from 0.
+ */
+struct bb_record {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t count;
+	uint32_t cycles_per_sec;
+	uint32_t len;
+	/** Fatal error reason, or UINT32_MAX for a shell commit. */
+	uint32_t reason;
+	/** CRC-32 of the payload. */
+	uint32_t crc;
+};
+
+static __noinit struct bb_ring ring;
+static uint32_t bb_cycles_per_sec;
+/* Set while a commit reads the ring, the periods meanwhile are dropped. */
+static volatile bool bb_frozen;
+
+void blackbox_record(uint32_t in, uint32_t out)
+{
+	struct bb_sample *s = &ring.samples[ring.head & (BB_SAMPLES - 1U)];
+
+	if (bb_frozen) {
+		return;
+	}
+
+	s->in = in;
+	s->out = out;
+	ring.head++;
+}
+
+static size_t sample_len(const struct bb_sample *s, const struct bb_sample *prev)
+{
+	struct pcodec_state in = { .prev = prev->in };
+	struct pcodec_state out = { .prev = prev->out };
+
+	return pcodec_encoded_len(&in, s->in) + pcodec_encoded_len(&out, s->out);
+}
+
+/* Stage bytes and write them to flash by whole write blocks. */
+struct bb_writer {
+	const struct flash_area *fa;
+	off_t off;
+	uint8_t buf[BB_WRITE_BLOCK + PCODEC_MAX_BYTES];
+	size_t fill;
+	size_t len;
+	uint32_t crc;
+	int err;
+	struct pcodec_state in;
+	struct pcodec_state out;
+};
+
+static void bb_flush(struct bb_writer *w, bool last)
+{
+	while ((w->err == 0) && ((w->fill >= BB_WRITE_BLOCK) ||
+				 (last && (w->fill > 0U)))) {
+		if (w->fill < BB_WRITE_BLOCK) {
+			memset(&w->buf[w->fill], 0xff, BB_WRITE_BLOCK - w->fill);
+			w->fill = BB_WRITE_BLOCK;
+		}
+		w->err = flash_area_write(w->fa, w->off, w->buf, BB_WRITE_BLOCK);
+		w->off += BB_WRITE_BLOCK;
+		w->fill -= BB_WRITE_BLOCK;
+		memmove(w->buf, &w->buf[BB_WRITE_BLOCK], w->fill);
+	}
+}
+
+static void bb_put(struct bb_writer *w, struct pcodec_state *st, uint32_t v)
+{
+	size_t len = pcodec_encode(st, &w->buf[w->fill], v);
+
+	w->crc = crc32_ieee_update(w->crc, &w->buf[w->fill], len);
+	w->fill += len;
+	w->len += len;
+	bb_flush(w, false);
+}
+
+static int bb_commit(uint32_t reason)
+{
+	static const struct bb_sample zero;
+	struct bb_writer w = { 0 };
+	struct bb_record rec = {
+		.magic = BB_FLASH_MAGIC,
+		.version = BB_FLASH_VERSION,
+		.cycles_per_sec = bb_cycles_per_sec,
+		.reason = reason,
+	};
+	uint32_t head, avail, first;
+	unsigned int key;
+	size_t budget;
+	int ret;
+
+	ret = flash_area_open(BB_PARTITION, &w.fa);
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* the erase and writes take about 20 ms, keep the window as it is */
+	key = irq_lock();
+	bb_frozen = true;
+	head = ring.head;
+	irq_unlock(key);
+	avail = MIN(head, BB_SAMPLES);
+
+	/*
+	 * Keep the newest samples which fit in the partition, with room for
+	 * the padding and for the oldest one being coded against 0.
+	 */
+	budget = w.fa->fa_size - sizeof(rec) - BB_WRITE_BLOCK -
+		 2U * PCODEC_MAX_BYTES;
+	for (first = head; first > head - avail; first--) {
+		const struct bb_sample *s = &ring.samples[(first - 1U) &
+							  (BB_SAMPLES - 1U)];
+		const struct bb_sample *prev = (first - 1U > head - avail) ?
+			&ring.samples[(first - 2U) & (BB_SAMPLES - 1U)] : &zero;
+		size_t len = sample_len(s, prev);
+
+		if (len > budget) {
+			break;
+		}
+		budget -= len;
+	}
+	rec.count = head - first;
+
+	ret = flash_area_erase(w.fa, 0, w.fa->fa_size);
+	if (ret < 0) {
+		goto out;
+	}
+
+	w.off = sizeof(rec);
+	for (uint32_t i = first; i != head; i++) {
+		const struct bb_sample *s = &ring.samples[i & (BB_SAMPLES - 1U)];
+
+		bb_put(&w, &w.in, s->in);
+		bb_put(&w, &w.out, s->out);
+	}
+	bb_flush(&w, true);
+	ret = w.err;
+	if (ret < 0) {
+		goto out;
+	}
+
+	/* header last: an interrupted commit leaves an erased record */
+	rec.len = w.len;
+	rec.crc = w.crc;
+	ret = flash_area_write(w.fa, 0, &rec, sizeof(rec));
+
+out:
+	bb_frozen = false;
+	flash_area_close(w.fa);
+
+	return ret;
+}
+
+int blackbox_commit(void)
+{
+	return bb_commit(UINT32_MAX);
+}
+
+void blackbox_init(uint32_t cycles_per_sec)
+{
+	bb_cycles_per_sec = cycles_per_sec;
+
+	if ((ring.magic == BB_RING_MAGIC) && (ring.fault != 0U)) {
+		int ret = bb_commit(ring.fault - 1U);
+
+		printk("Black box of fatal error %u committed (%d)\n",
+		       ring.fault - 1U, ret);
+	}
+
+	memset(&ring, 0, sizeof(ring));
+	ring.magic = BB_RING_MAGIC;
+}
+
+void k_sys_fatal_error_handler(unsigned int reason, const z_arch_esf_t *esf)
+{
+	ARG_UNUSED(esf);
+
+	/* flash is not safe to program from here: commit at next boot */
+	ring.fault = reason + 1U;
+	sys_reboot(SYS_REBOOT_WARM);
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_bb_commit(const struct shell *sh, size_t argc, char **argv)
+{
+	int ret = blackbox_commit();
+
+	if (ret < 0) {
+		shell_error(sh, "commit failed (%d)", ret);
+		return ret;
+	}
+
+	return 0;
+}
+
+/* Stream the raw flash record as hex, to be decoded on the host. */
+static int cmd_bb_dump(const struct shell *sh, size_t argc, char **argv)
+{
+	const struct flash_area *fa;
+	struct bb_record rec;
+	uint8_t buf[16];
+	int ret;
+
+	ret = flash_area_open(BB_PARTITION, &fa);
+	if (ret < 0) {
+		return ret;
+	}
+
+	ret = flash_area_read(fa, 0, &rec, sizeof(rec));
+	if ((ret == 0) && ((rec.magic != BB_FLASH_MAGIC) ||
+			   (rec.len > fa->fa_size - sizeof(rec)))) {
+		shell_error(sh, "no record");
+		ret = -ENOENT;
+	}
+
+	for (size_t off = 0; (ret == 0) && (off < sizeof(rec) + rec.len);
+	     off += sizeof(buf)) {
+		size_t len = MIN(sizeof(buf), sizeof(rec) + rec.len - off);
+
+		ret = flash_area_read(fa, off, buf, len);
+		if (ret == 0) {
+			shell_hexdump_line(sh, off, buf, len);
+		}
+	}
+
+	flash_area_close(fa);
+
+	return ret;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_bb,
+	SHELL_CMD(commit, NULL, "Commit the recorded periods to flash",
+		  cmd_bb_commit),
+	SHELL_CMD(dump, NULL, "Dump the flash record", cmd_bb_dump),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(bb, &sub_bb, "Black-box recorder", NULL);
+#endif
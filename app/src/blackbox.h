@@ -0,0 +1,49 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_BLACKBOX_H_
+#define APP_BLACKBOX_H_
+
+#include <stdint.h>
+
+/**
+ * Black-box recorder of the last CONFIG_APP_BLACKBOX_SAMPLES periods.
+ *
+ * Samples are kept raw in a RAM ring which survives warm resets. They are
+ * coded with include/codec/period_codec.h only when committed to the
+ * "blackbox" flash partition: on "bb commit", or at the boot following a
+ * fatal error. tools/pcodec decodes the "bb dump" output.
+ */
+
+/**
+ * Start recording.
+ *
+ * Commits the ring left by a fatal error, if any, then clears it.
+ *
+ * @param cycles_per_sec Clock of the recorded periods.
+ */
+void blackbox_init(uint32_t cycles_per_sec);
+
+/**
+ * Record an input period and the output period computed from it.
+ *
+ * Meant for the capture callback: a couple of stores and an increment.
+ *
+ * @param in Input period (cycles), 0 if the input stopped.
+ * @param out Output period (cycles), 0 if the output is stopped.
+ */
+void blackbox_record(uint32_t in, uint32_t out);
+
+/**
+ * Commit the ring to flash.
+ *
+ * Recording is suspended until the commit returns, so that the record holds
+ * the periods up to the call.
+ *
+ * @retval 0 If successful.
+ * @retval -errno Negative errno code on failure.
+ */
+int blackbox_commit(void);
+
+#endif /* APP_BLACKBOX_H_ */
@@ -0,0 +1,217 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/drivers/pwm.h>
+#include <drivers/ic.h>
+
+#include "calib.h"
+
+/* Fractional bits of the period scale factor. */
+#define CAL_SCALE_BITS 30U
+
+static struct test_pwm in_pin;
+static struct test_pwm out_pin;
+static int32_t cal_ppm;
+/* 1 / (1 + correction), applied to the periods captured by the PWM driver. */
+static uint32_t cal_scale = 1UL << CAL_SCALE_BITS;
+
+/* Measurement shared with the capture callback. */
+static volatile uint32_t wanted;
+static volatile uint32_t seen;
+static volatile bool stalled;
+static uint64_t sum;
+static K_SEM_DEFINE(calib_done, 0, 1);
+
+void calib_record(uint32_t period)
+{
+	if (seen >= wanted) {
+		return;
+	}
+
+	if (period == 0U) {
+		stalled = true;
+		wanted = 0U;
+		k_sem_give(&calib_done);
+		return;
+	}
+
+	sum += period;
+	if (++seen == wanted) {
+		k_sem_give(&calib_done);
+	}
+}
+
+uint32_t calib_correct(uint32_t cycles)
+{
+	return (uint32_t)(((uint64_t)cycles * cal_scale) >> CAL_SCALE_BITS);
+}
+
+int32_t calib_get_ppm(void)
+{
+	return cal_ppm;
+}
+
+static int calib_apply(int32_t ppm)
+{
+	int ret = 0;
+
+	/* the PWM driver takes no correction: see calib_correct() */
+	if (in_pin.is_ic) {
+		ret = ic_set_calibration(in_pin.dev, ppm);
+	}
+	if ((ret == 0) && out_pin.is_ic && (out_pin.dev != in_pin.dev)) {
+		ret = ic_set_calibration(out_pin.dev, ppm);
+	}
+	if (ret == 0) {
+		cal_scale = (uint32_t)(((uint64_t)USEC_PER_SEC << CAL_SCALE_BITS) /
+				       (uint32_t)(USEC_PER_SEC + ppm));
+		cal_ppm = ppm;
+	}
+
+	return ret;
+}
+
+#if defined(CONFIG_SETTINGS)
+static int calib_settings_set(const char *name, size_t len,
+			      settings_read_cb read_cb, void *cb_arg)
+{
+	int32_t ppm;
+
+	if (!settings_name_steq(name, "ppm", NULL) || (len != sizeof(ppm))) {
+		return -ENOENT;
+	}
+
+	if (read_cb(cb_arg, &ppm, sizeof(ppm)) != sizeof(ppm)) {
+		return -EIO;
+	}
+
+	return calib_apply(ppm);
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(calib, "calib", NULL, calib_settings_set, NULL,
+			       NULL);
+#endif
+
+void calib_init(const struct test_pwm *in, const struct test_pwm *out)
+{
+	in_pin = *in;
+	out_pin = *out;
+
+#if defined(CONFIG_SETTINGS)
+	if ((settings_subsys_init() == 0) &&
+	    (settings_load_subtree("calib") == 0) && (cal_ppm != 0)) {
+		printk("Clock correction %d ppm\n", cal_ppm);
+	}
+#endif
+}
+
+/**
+ * Measure the reference and derive the clock error.
+ *
+ * @param period_us Reference period (usec).
+ * @param[out] ppm New correction, including the current one.
+ */
+static int calib_measure(uint32_t period_us, int32_t *ppm)
+{
+	uint64_t cycles_per_sec;
+	uint64_t expected;
+	int64_t err_ppm;
+	int ret;
+
+	if (in_pin.is_ic) {
+		ret = ic_get_cycles_per_sec(in_pin.dev, in_pin.pwm,
+					    &cycles_per_sec);
+	} else {
+		ret = pwm_get_cycles_per_sec(in_pin.dev, in_pin.pwm,
+					     &cycles_per_sec);
+	}
+	if (ret < 0) {
+		return ret;
+	}
+
+	k_sem_reset(&calib_done);
+	sum = 0U;
+	stalled = false;
+	seen = 0U;
+	wanted = CONFIG_APP_CALIB_PERIODS;
+
+	if ((k_sem_take(&calib_done, K_MSEC(CONFIG_APP_CALIB_PERIODS *
+					    (period_us / 1000U + 1U) + 1000U)) != 0) ||
+	    stalled) {
+		wanted = 0U;
+		return -ETIMEDOUT;
+	}
+
+	/* cycles the reference should span at the currently known rate */
+	expected = (uint64_t)CONFIG_APP_CALIB_PERIODS *
+		   ((uint64_t)period_us * cycles_per_sec / USEC_PER_SEC);
+	if (expected == 0U) {
+		return -ERANGE;
+	}
+
+	err_ppm = (int64_t)(sum * 1000000U / expected) - 1000000;
+	*ppm = (int32_t)(((1000000 + (int64_t)cal_ppm) * (1000000 + err_ppm)) /
+			 1000000 - 1000000);
+	if ((*ppm > CONFIG_APP_CALIB_MAX_PPM) ||
+	    (*ppm < -CONFIG_APP_CALIB_MAX_PPM)) {
+		return -ERANGE;
+	}
+
+	return 0;
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_calib(const struct shell *sh, size_t argc, char **argv)
+{
+	int32_t ppm = 0;
+	int ret;
+
+	if (argc == 1) {
+		shell_print(sh, "correction %d ppm", cal_ppm);
+		return 0;
+	}
+
+	if (strcmp(argv[1], "clear") != 0) {
+		uint32_t period_us = strtoul(argv[1], NULL, 0);
+
+		if (period_us == 0U) {
+			shell_error(sh, "usage: calib [<period_us>|clear]");
+			return -EINVAL;
+		}
+
+		ret = calib_measure(period_us, &ppm);
+		if (ret < 0) {
+			shell_error(sh, "measurement failed (%d)", ret);
+			return ret;
+		}
+	}
+
+	ret = calib_apply(ppm);
+	if (ret < 0) {
+		shell_error(sh, "correction not applied (%d)", ret);
+		return ret;
+	}
+
+#if defined(CONFIG_SETTINGS)
+	ret = settings_save_one("calib/ppm", &cal_ppm, sizeof(cal_ppm));
+	if (ret < 0) {
+		shell_warn(sh, "correction not stored (%d)", ret);
+	}
+#endif
+
+	shell_print(sh, "correction %d ppm", cal_ppm);
+
+	return 0;
+}
+
+SHELL_CMD_ARG_REGISTER(calib, NULL,
+		       "Measure the clock error on a reference: "
+		       "calib [<period_us>|clear]",
+		       cmd_calib, 1, 1);
+#endif
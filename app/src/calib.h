@@ -0,0 +1,59 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_CALIB_H_
+#define APP_CALIB_H_
+
+#include <stdint.h>
+
+#include "app.h"
+
+/**
+ * HSI drift compensation.
+ *
+ * The board runs from the internal HSI oscillator: every captured and
+ * generated period carries its tolerance. "calib <period_us>" measures
+ * CONFIG_APP_CALIB_PERIODS periods of a reference of known period fed to
+ * the capture input, derives the clock error in ppm and hands it to the
+ * IC driver with ic_set_calibration(), which folds it into its cached
+ * clock rate. The PWM driver has no such hook: an input it captures has
+ * its periods brought to the nominal clock by calib_correct() instead.
+ * With CONFIG_SETTINGS the correction is stored under "calib/ppm" and
+ * applied again at boot.
+ */
+
+/**
+ * Apply the stored correction.
+ *
+ * @param in Capture input.
+ * @param out Output pin, also corrected when served by another IC device.
+ */
+void calib_init(const struct test_pwm *in, const struct test_pwm *out);
+
+/**
+ * Feed an input period to a running calibration.
+ *
+ * Called from the capture callback only.
+ *
+ * @param period Input period (cycles), 0 when the input stopped.
+ */
+void calib_record(uint32_t period);
+
+/**
+ * Correct a period captured by the PWM driver.
+ *
+ * Called from the capture callback, before the period is used: a 32 by
+ * 32 bit multiplication. Inputs served by the IC driver are corrected by
+ * the driver and must not go through it.
+ *
+ * @param cycles Captured period or pulse (cycles).
+ *
+ * @return The same duration in cycles of the nominal clock.
+ */
+uint32_t calib_correct(uint32_t cycles);
+
+/** Current correction (ppm). */
+int32_t calib_get_ppm(void);
+
+#endif /* APP_CALIB_H_ */
@@ -0,0 +1,136 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include <drivers/ic.h>
+
+#include "deadline.h"
+
+/*
+ * Fail-safe path:
+ *
+ * - When input and output are channels of the same IC device, the driver
+ *   pass-through makes each input edge start an output pulse in hardware
+ *   (timer slave reset mode): the output follows the input unscaled, with
+ *   no CPU involved, until the timings are back under the deadline.
+ * - Otherwise (e.g. separate timers, or a timer without slave controller)
+ *   the last output is simply held: the callback stops touching it.
+ *
+ * The capture keeps running in both cases, so the latency is still
+ * measured and the monitor can tell when to switch back.
+ */
+
+static struct deadline_stats stats;
+static struct test_pwm in_pin;
+static struct test_pwm out_pin;
+static uint32_t limit_cycles;
+static uint32_t pulse_cycles;
+static uint32_t cps;
+static uint32_t good;
+static bool running;
+
+int deadline_init(const struct test_pwm *in, const struct test_pwm *out,
+		  uint32_t cycles_per_sec)
+{
+	uint32_t age;
+
+	if (!in->is_ic ||
+	    (ic_get_capture_age(in->dev, in->pwm, &age) == -ENOSYS)) {
+		printk("Deadline monitor not supported by the input\n");
+		return -ENOTSUP;
+	}
+
+	in_pin = *in;
+	out_pin = *out;
+	cps = cycles_per_sec;
+	limit_cycles = (uint32_t)((uint64_t)CONFIG_APP_DEADLINE_US *
+				  cycles_per_sec / USEC_PER_SEC);
+	pulse_cycles = (uint32_t)((uint64_t)CONFIG_APP_DEADLINE_PULSE_US *
+				  cycles_per_sec / USEC_PER_SEC);
+	running = true;
+
+	printk("Deadline %u us (%u cycles)\n", CONFIG_APP_DEADLINE_US,
+	       limit_cycles);
+
+	return 0;
+}
+
+static void failsafe_enter(void)
+{
+	stats.failsafe = true;
+	stats.trips++;
+
+	stats.passthrough = out_pin.is_ic && (out_pin.dev == in_pin.dev) &&
+			    (ic_set_passthrough(in_pin.dev, in_pin.pwm,
+						out_pin.pwm, pulse_cycles) == 0);
+}
+
+static void failsafe_leave(void)
+{
+	if (stats.passthrough) {
+		ic_set_passthrough(in_pin.dev, in_pin.pwm, out_pin.pwm, 0u);
+		stats.passthrough = false;
+	}
+
+	stats.failsafe = false;
+	stats.restores++;
+}
+
+bool deadline_update(void)
+{
+	uint32_t age;
+	uint32_t us;
+
+	if (!running || (ic_get_capture_age(in_pin.dev, in_pin.pwm, &age) < 0)) {
+		return true;
+	}
+
+	stats.checked++;
+	us = (uint32_t)((uint64_t)age * USEC_PER_SEC / cps);
+	if (us > stats.max_latency_us) {
+		stats.max_latency_us = us;
+	}
+
+	if (age > limit_cycles) {
+		stats.misses++;
+		stats.consecutive++;
+		good = 0u;
+		if (!stats.failsafe &&
+		    (stats.consecutive >= CONFIG_APP_DEADLINE_MISSES)) {
+			failsafe_enter();
+		}
+	} else {
+		stats.consecutive = 0u;
+		if (stats.failsafe && (++good >= CONFIG_APP_DEADLINE_RECOVER)) {
+			good = 0u;
+			failsafe_leave();
+		}
+	}
+
+	return !stats.failsafe;
+}
+
+const struct deadline_stats *deadline_get_stats(void)
+{
+	return &stats;
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_deadline(const struct shell *sh, size_t argc, char **argv)
+{
+	shell_print(sh, "checked %u misses %u consecutive %u", stats.checked,
+		    stats.misses, stats.consecutive);
+	shell_print(sh, "trips %u restores %u", stats.trips, stats.restores);
+	shell_print(sh, "max latency %u us", stats.max_latency_us);
+	shell_print(sh, "failsafe %d passthrough %d", stats.failsafe,
+		    stats.passthrough);
+
+	return 0;
+}
+
+SHELL_CMD_REGISTER(deadline, NULL, "Edge to output deadline counters",
+		   cmd_deadline);
+#endif
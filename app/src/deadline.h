@@ -0,0 +1,65 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_DEADLINE_H_
+#define APP_DEADLINE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app.h"
+
+/** Deadline monitor counters. */
+struct deadline_stats {
+	/** Edges checked. */
+	uint32_t checked;
+	/** Edges processed later than CONFIG_APP_DEADLINE_US. */
+	uint32_t misses;
+	/** Current run of consecutive misses. */
+	uint32_t consecutive;
+	/** Switches to the fail-safe path. */
+	uint32_t trips;
+	/** Switches back to the computed output. */
+	uint32_t restores;
+	/** Largest edge to output latency seen (usec). */
+	uint32_t max_latency_us;
+	/** Whether the fail-safe path drives the output. */
+	bool failsafe;
+	/** Whether the output is a hardware pass-through while in fail-safe. */
+	bool passthrough;
+};
+
+/**
+ * Start monitoring the edge to output latency.
+ *
+ * The latency is read from the capture driver with ic_get_capture_age(),
+ * so the monitor stays disabled for inputs served by the PWM driver.
+ *
+ * @param in Capture input.
+ * @param out Output pin.
+ * @param cycles_per_sec Clock of the capture input.
+ *
+ * @retval 0 If the monitor is running.
+ * @retval -ENOTSUP If the input cannot report the age of its last edge.
+ */
+int deadline_init(const struct test_pwm *in, const struct test_pwm *out,
+		  uint32_t cycles_per_sec);
+
+/**
+ * Check the latency of the edge being processed.
+ *
+ * Called from the capture callback right before the output is updated.
+ * After CONFIG_APP_DEADLINE_MISSES consecutive misses, the output is
+ * handed over to the fail-safe path; after CONFIG_APP_DEADLINE_RECOVER
+ * consecutive edges on time, it is handed back.
+ *
+ * @return true if the callback must update the output, false while the
+ *         fail-safe path drives it.
+ */
+bool deadline_update(void);
+
+/** Current counters. */
+const struct deadline_stats *deadline_get_stats(void);
+
+#endif /* APP_DEADLINE_H_ */
@@ -0,0 +1,87 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+
+#include <speedxform/quantile.h>
+
+#include "jitter.h"
+
+static struct qhist hist;
+static uint32_t prev;
+/* Bumped by the callback on every change of hist. */
+static volatile uint32_t hist_seq;
+/* Copy of hist read by jitter_get(), kept off the stacks of its callers. */
+static struct qhist snap;
+static K_MUTEX_DEFINE(snap_lock);
+
+void jitter_record(uint32_t period)
+{
+	if ((period != 0U) && (prev != 0U)) {
+		qhist_add(&hist, (period > prev) ? period - prev : prev - period,
+			  prev);
+		hist_seq++;
+	}
+	prev = period;
+}
+
+void jitter_get(struct jitter_summary *s)
+{
+	uint32_t seq;
+
+	k_mutex_lock(&snap_lock, K_FOREVER);
+
+	/*
+	 * The callback may be halving the counts: copy them again if it ran
+	 * during the copy, then scan the copy with interrupts enabled.
+	 */
+	do {
+		seq = hist_seq;
+		compiler_barrier();
+		memcpy(&snap, &hist, sizeof(snap));
+		compiler_barrier();
+	} while (seq != hist_seq);
+
+	s->p50 = qhist_quantile_ppm(&snap, 500U);
+	s->p95 = qhist_quantile_ppm(&snap, 950U);
+	s->p99 = qhist_quantile_ppm(&snap, 990U);
+	s->samples = snap.total;
+
+	k_mutex_unlock(&snap_lock);
+}
+
+void jitter_reset(void)
+{
+	unsigned int key = irq_lock();
+
+	qhist_reset(&hist);
+	prev = 0U;
+	hist_seq++;
+	irq_unlock(key);
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_jitter(const struct shell *sh, size_t argc, char **argv)
+{
+	struct jitter_summary s;
+
+	if ((argc > 1) && (strcmp(argv[1], "reset") == 0)) {
+		jitter_reset();
+		return 0;
+	}
+
+	jitter_get(&s);
+	shell_print(sh, "samples %u", s.samples);
+	shell_print(sh, "p50 %u ppm p95 %u ppm p99 %u ppm", s.p50, s.p95,
+		    s.p99);
+
+	return 0;
+}
+
+SHELL_CMD_ARG_REGISTER(jitter, NULL,
+		       "Period jitter quantiles, \"jitter reset\" to restart",
+		       cmd_jitter, 1, 1);
+#endif
@@ -0,0 +1,34 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_JITTER_H_
+#define APP_JITTER_H_
+
+#include <stdint.h>
+
+/** Period to period jitter quantiles, in ppm of the period. */
+struct jitter_summary {
+	uint32_t p50;
+	uint32_t p95;
+	uint32_t p99;
+	/** Periods counted since the last reset. */
+	uint32_t samples;
+};
+
+/**
+ * Count the jitter between an input period and the previous one.
+ *
+ * Called from the capture callback only.
+ *
+ * @param period Input period (cycles), 0 when the input stopped.
+ */
+void jitter_record(uint32_t period);
+
+/** Get the current quantiles. */
+void jitter_get(struct jitter_summary *s);
+
+/** Forget the counted periods. */
+void jitter_reset(void);
+
+#endif /* APP_JITTER_H_ */
@@ -4,6 +4,38 @@
 #include <zephyr/drivers/pwm.h>
 #include <drivers/ic.h>
 
+#include <speedxform/pipeline.h>
+
+#include "app.h"
+
+#if defined(CONFIG_500E_MODE_DEV)
+#include "profile.h"
+#endif
+#if defined(CONFIG_APP_BIST)
+#include "bist.h"
+#endif
+#if defined(CONFIG_APP_BLACKBOX)
+#include "blackbox.h"
+#endif
+#if defined(CONFIG_APP_TELEMETRY)
+#include "telemetry.h"
+#endif
+#if defined(CONFIG_APP_DEADLINE)
+#include "deadline.h"
+#endif
+#if defined(CONFIG_APP_CALIB)
+#include "calib.h"
+#endif
+#if defined(CONFIG_APP_JITTER)
+#include "jitter.h"
+#endif
+#if defined(CONFIG_APP_TUNE)
+#include "tune.h"
+#endif
+#if defined(CONFIG_APP_MOTORS)
+#include "motors.h"
+#endif
+
 
 /* IOs configuration. */
 #if defined(CONFIG_500E_MODE_DEV)
@@ -18,6 +50,9 @@
 
 #define PWM_NODE DT_INST(0, app_pwm_ios)
 
+/* Whether a pin is served by the IC driver rather than the PWM driver. */
+#define IS_IC_CTLR(ctlr) DT_NODE_HAS_COMPAT(ctlr, st_stm32_ic)
+
 #define IC_IN_CTLR \
 	DT_PWMS_CTLR_BY_IDX(PWM_NODE, IC_IN_IDX)
 #define IC_IN_CHANNEL \
@@ -32,24 +67,152 @@
 #define PWM_OUT_FLAGS \
 	DT_PWMS_FLAGS_BY_IDX(PWM_NODE, PWM_OUT_IDX)
 
-#if defined(CONFIG_500E_MODE_DEV)
-#define drv_(func) ic_##func
-
+#if defined(CONFIG_500E_MODE_DEV) || defined(CONFIG_APP_BIST)
+#define HAS_TEST_PIN 1
 #define PWM_TEST_CTLR \
 	DT_PWMS_CTLR_BY_IDX(PWM_NODE, PWM_TEST_IDX)
 #define PWM_TEST_CHANNEL \
 	DT_PWMS_CHANNEL_BY_IDX(PWM_NODE, PWM_TEST_IDX)
 #define PWM_TEST_FLAGS \
 	DT_PWMS_FLAGS_BY_IDX(PWM_NODE, PWM_TEST_IDX)
+#endif
+
+/* Further outputs fed from the same capture, see sx_pipeline_tap(). */
+#if DT_NODE_HAS_PROP(PWM_NODE, out_pwms)
+#define OUT_TAPS DT_PROP_LEN(PWM_NODE, out_pwms)
+BUILD_ASSERT(DT_PROP_LEN(PWM_NODE, out_ratios) == 2 * OUT_TAPS,
+	     "out-ratios needs a <num den> pair per out-pwms pin");
+
+#define OUT_TAP_PIN(node, prop, idx)					\
+	{								\
+		.dev = DEVICE_DT_GET(DT_PHANDLE_BY_IDX(node, prop, idx)), \
+		.pwm = DT_PHA_BY_IDX(node, prop, idx, channel),		\
+		.flags = DT_PHA_BY_IDX(node, prop, idx, flags),		\
+		.is_ic = IS_IC_CTLR(DT_PHANDLE_BY_IDX(node, prop, idx)), \
+	},
+
+static const struct test_pwm out_tap_pins[] = {
+	DT_FOREACH_PROP_ELEM(PWM_NODE, out_pwms, OUT_TAP_PIN)
+};
+static const uint32_t out_tap_ratios[] = DT_PROP(PWM_NODE, out_ratios);
+static struct sx_tap out_taps[OUT_TAPS];
+#else
+#define OUT_TAPS 0
+#endif
+
+/* Capture goes through the IC driver or through the PWM capture API. */
+#if IS_IC_CTLR(IC_IN_CTLR)
+#define drv_(func) ic_##func
 #else
 #define drv_(func) pwm_##func
 #endif
 
-struct test_pwm {
-	const struct device *dev;
-	uint32_t pwm;
-	pwm_flags_t flags;
+/*
+ * With duty-cycled capture the output holds the last period between bursts,
+ * which must not be taken for a stalled input. The driver only samples in
+ * bursts on free-running timers: reset mode inputs capture every edge.
+ */
+#if defined(CONFIG_IC_STM32_DUTY_CYCLE) && IS_IC_CTLR(IC_IN_CTLR) && \
+	DT_PROP_OR(IC_IN_CTLR, free_running, 0)
+#define IC_IN_DUTY IC_CAPTURE_DUTY_CYCLED
+BUILD_ASSERT((CONFIG_APP_INPUT_TIMEOUT_MS == 0) ||
+	     (CONFIG_APP_INPUT_TIMEOUT_MS >
+	      CONFIG_IC_STM32_DUTY_CYCLE_MAX_IDLE_MS),
+	     "Input timeout shorter than the capture idle interval");
+#else
+#define IC_IN_DUTY 0
+#endif
+
+/*
+ * Input to output period transform, see speedxform/xform.h. The time window
+ * is set in capture cycles once the capture clock is known.
+ */
+static struct xform_params xform_params = {
+	.ratio_num = CONFIG_APP_XFORM_RATIO_NUM,
+	.ratio_den = CONFIG_APP_XFORM_RATIO_DEN,
+	.window = CONFIG_APP_XFORM_WINDOW,
+	.hysteresis_ppm = CONFIG_APP_XFORM_HYSTERESIS_PPM,
+	.gain = CONFIG_APP_XFORM_GAIN,
 };
+static struct sx_pipeline pipeline;
+
+/* Edges seen by the capture callback, used to detect a stalled input. */
+static volatile uint32_t edge_count;
+
+/*
+ * IC outputs share their timer with the capture (free-running mode), so the
+ * timings are in that timer's cycles.
+ */
+static int output_cycles_per_sec(const struct test_pwm *out,
+				 uint64_t *cycles_per_sec)
+{
+	if (out->is_ic) {
+		return ic_get_cycles_per_sec(out->dev, out->pwm, cycles_per_sec);
+	}
+
+	return pwm_get_cycles_per_sec(out->dev, out->pwm, cycles_per_sec);
+}
+
+int output_set_cycles(const struct test_pwm *out, uint32_t period_cycles,
+		      uint32_t pulse_cycles)
+{
+	if (out->is_ic) {
+		return ic_set_cycles(out->dev, out->pwm, period_cycles,
+				     pulse_cycles, out->flags);
+	}
+
+	return pwm_set_cycles(out->dev, out->pwm, period_cycles, pulse_cycles,
+			      out->flags);
+}
+
+/* Output clock for the pipeline, in step with the capture clock. */
+uint32_t output_hz(const struct test_pwm *out)
+{
+	uint64_t cycles_per_sec = 0;
+
+	output_cycles_per_sec(out, &cycles_per_sec);
+#if defined(CONFIG_APP_CALIB)
+	/* Both timers run from the HSI: keep their ratio nominal. */
+	if (!out->is_ic) {
+		cycles_per_sec = cycles_per_sec *
+				 (1000000 + calib_get_ppm()) / 1000000;
+	}
+#endif
+
+	return (uint32_t)cycles_per_sec;
+}
+
+/* Stop the output and the taps. */
+static void outputs_stop(const struct test_pwm *out)
+{
+	output_set_cycles(out, 0, 0);
+#if OUT_TAPS > 0
+	for (uint32_t i = 0; i < OUT_TAPS; i++) {
+		output_set_cycles(&out_tap_pins[i], 0, 0);
+	}
+#endif
+}
+
+int output_set(const struct test_pwm *out, uint64_t period_usec,
+	       uint64_t pulse_usec)
+{
+	uint64_t cycles_per_sec;
+	int ret;
+
+	ret = output_cycles_per_sec(out, &cycles_per_sec);
+	if (ret < 0) {
+		return ret;
+	}
+
+	period_usec = period_usec * cycles_per_sec / USEC_PER_SEC;
+	pulse_usec = pulse_usec * cycles_per_sec / USEC_PER_SEC;
+	if ((period_usec > UINT32_MAX) || (pulse_usec > UINT32_MAX)) {
+		return -ERANGE;
+	}
+
+	return output_set_cycles(out, (uint32_t)period_usec,
+				 (uint32_t)pulse_usec);
+}
 
 static void continuous_capture_callback(const struct device *dev,
 					uint32_t pwm,
@@ -58,38 +221,101 @@ static void continuous_capture_callback(const struct device *dev,
 					int status,
 					void *user_data)
 {
-	uint64_t period = 0;
-	uint64_t pulse = 0;
+	struct sx_output o;
+#if OUT_TAPS > 0
+	struct sx_output tap_out[OUT_TAPS];
+#endif
 	struct test_pwm out;
 
+	edge_count++;
+
 	out.dev = DEVICE_DT_GET(PWM_OUT_CTLR);
 	out.pwm = PWM_OUT_CHANNEL;
 	out.flags = PWM_OUT_FLAGS;
+	out.is_ic = IS_IC_CTLR(PWM_OUT_CTLR);
+
+	if (status != 0) {
+		printk("Overflow (%d) \n", status);
+		sx_pipeline_step(&pipeline, 0, 0, &o);
+		outputs_stop(&out);
+#if defined(CONFIG_APP_BLACKBOX)
+		blackbox_record(0, 0);
+#endif
+#if defined(CONFIG_APP_TELEMETRY)
+		telemetry_record(0, 0);
+#endif
+#if defined(CONFIG_APP_CALIB)
+		calib_record(0);
+#endif
+#if defined(CONFIG_APP_JITTER)
+		jitter_record(0);
+#endif
+		return;
+	}
 
-	drv_(cycles_to_usec)(dev, pwm, period_cycles, &period);
+#if defined(CONFIG_APP_CALIB) && !IS_IC_CTLR(IC_IN_CTLR)
+	period_cycles = calib_correct(period_cycles);
+	pulse_cycles = calib_correct(pulse_cycles);
+#endif
 #if defined(CONFIG_500E_MODE_DEV)
 	pulse_cycles = 3 * period_cycles / 4;
 #endif
-	drv_(cycles_to_usec)(dev, pwm, pulse_cycles, &pulse);
+	sx_pipeline_step(&pipeline, period_cycles, pulse_cycles, &o);
+#if OUT_TAPS > 0
+	for (uint32_t i = 0; i < OUT_TAPS; i++) {
+		sx_pipeline_tap(&pipeline, &o, pulse_cycles, &out_taps[i],
+				&tap_out[i]);
+	}
+#endif
+#if defined(CONFIG_APP_BLACKBOX)
+	blackbox_record(period_cycles, o.xform_cycles);
+#endif
+#if defined(CONFIG_APP_TELEMETRY)
+	telemetry_record(period_cycles, o.xform_cycles);
+#endif
+#if defined(CONFIG_APP_CALIB)
+	calib_record(period_cycles);
+#endif
+#if defined(CONFIG_APP_JITTER)
+	jitter_record(period_cycles);
+#endif
+
+#if defined(CONFIG_APP_DEADLINE)
+	if (!deadline_update()) {
+		return;
+	}
+#endif
+	/* all timings are ready: update the outputs back to back */
+	output_set_cycles(&out, o.period, o.pulse);
+#if OUT_TAPS > 0
+	for (uint32_t i = 0; i < OUT_TAPS; i++) {
+		output_set_cycles(&out_tap_pins[i], tap_out[i].period,
+				  tap_out[i].pulse);
+	}
+#endif
 
-	/* Divide speed by 2. */
-	period = period * 2;
-	pulse = pulse * 2;
+	/*
+	 * The text trace blocks for about 1 ms per edge on the UART: left out
+	 * of deadline monitored builds, where it would delay the next edge.
+	 */
+#if !defined(CONFIG_APP_TELEMETRY) && !defined(CONFIG_APP_DEADLINE)
+	{
+		uint64_t period = 0;
 
-	if (status == 0) {
+		drv_(cycles_to_usec)(dev, pwm, o.xform_cycles, &period);
 		printk("%d/%d \n",period_cycles, (uint32_t)period / 1000);
-		pwm_set(out.dev, out.pwm, PWM_MSEC(period/1000), PWM_MSEC(pulse), 0);
-	} else {
-		printk("Overflow (%d) \n", status);
-		pwm_set(out.dev, out.pwm, PWM_MSEC(0), PWM_MSEC(0), 0);
 	}
+#endif
 }
 
 void main(void)
 {
 	struct test_pwm in, out;
+#if defined(HAS_TEST_PIN)
+	struct test_pwm test;
+#endif
 #if defined(CONFIG_500E_MODE_DEV)
-	struct test_pwm test
+	bool profile_dma;
 #endif
 
 	printk("500e speed unlock");
@@ -97,6 +323,7 @@ void main(void)
 	in.dev = DEVICE_DT_GET(IC_IN_CTLR);
 	in.pwm = IC_IN_CHANNEL;
 	in.flags = IC_IN_FLAGS;
+	in.is_ic = IS_IC_CTLR(IC_IN_CTLR);
 	if (!device_is_ready(in.dev)) {
 		printk("pwm loopback intput device is not ready\n");
 		return;
@@ -105,46 +332,112 @@ void main(void)
 	out.dev = DEVICE_DT_GET(PWM_OUT_CTLR);
 	out.pwm = PWM_OUT_CHANNEL;
 	out.flags = PWM_OUT_FLAGS;
+	out.is_ic = IS_IC_CTLR(PWM_OUT_CTLR);
 	if (!device_is_ready(out.dev)) {
 		printk("pwm loopback output device is not ready\n");
 		return;
 	}
 
-#if defined(CONFIG_500E_MODE_DEV)
+#if defined(HAS_TEST_PIN)
 	test.dev = DEVICE_DT_GET(PWM_TEST_CTLR);
 	test.pwm = PWM_TEST_CHANNEL;
 	test.flags = PWM_TEST_FLAGS;
+	test.is_ic = IS_IC_CTLR(PWM_TEST_CTLR);
 	if (!device_is_ready(test.dev)) {
 		printk("pwm loopback test device is not ready\n");
 		return;
 	}
+#endif
+
+#if defined(CONFIG_APP_CALIB)
+	calib_init(&in, &out);
+#endif
+
+#if defined(CONFIG_APP_BIST)
+	bist_run(&in, &test);
+#endif
 
-	if (pwm_set(test.dev, test.pwm, PWM_MSEC(1000), PWM_MSEC(250), 0)) {
-			printk("Fail to set the period and pulse width\n");
-			return;
+	{
+		uint64_t cycles_per_sec = 0;
+
+		drv_(get_cycles_per_sec)(in.dev, in.pwm, &cycles_per_sec);
+		xform_params.window_cycles = (uint32_t)MIN(
+			CONFIG_APP_XFORM_WINDOW_MS * cycles_per_sec /
+			MSEC_PER_SEC, UINT32_MAX);
+		sx_pipeline_init(&pipeline, &xform_params,
+				 (uint32_t)cycles_per_sec, output_hz(&out));
+#if OUT_TAPS > 0
+		for (uint32_t i = 0; i < OUT_TAPS; i++) {
+			if (!device_is_ready(out_tap_pins[i].dev) ||
+			    (out_tap_ratios[2 * i + 1] == 0U)) {
+				printk("output tap %u is not usable\n", i);
+				return;
+			}
+			out_taps[i].ratio_num = out_tap_ratios[2 * i];
+			out_taps[i].ratio_den = out_tap_ratios[2 * i + 1];
+			out_taps[i].out_hz = output_hz(&out_tap_pins[i]);
+		}
+#endif
+#if defined(CONFIG_APP_TUNE)
+		tune_init(&pipeline, (uint32_t)cycles_per_sec);
+#endif
+#if defined(CONFIG_APP_BLACKBOX)
+		blackbox_init((uint32_t)cycles_per_sec);
+#endif
+#if defined(CONFIG_APP_TELEMETRY)
+		telemetry_init((uint32_t)cycles_per_sec);
+#endif
+#if defined(CONFIG_APP_DEADLINE)
+		deadline_init(&in, &out, (uint32_t)cycles_per_sec);
+#endif
 	}
+
+#if defined(CONFIG_500E_MODE_DEV)
+	/* Without DMA, the loop below plays the profile from the CPU. */
+	profile_dma = !test.is_ic &&
+		      (profile_dma_start(test.dev, test.pwm, test.flags) == 0);
+	printk("Test profile played by %s\n", profile_dma ? "DMA" : "CPU");
 #endif
 
 	if(drv_(configure_capture)(in.dev, in.pwm, IC_CAPTURE_MODE_CONTINUOUS |
-					    IC_CAPTURE_TYPE_PERIOD | PWM_POLARITY_NORMAL,
+					    IC_CAPTURE_TYPE_PERIOD | PWM_POLARITY_NORMAL |
+					    IC_IN_DUTY,
 					    continuous_capture_callback, NULL))
 		printk("Failed to configure capture");
 
+#if defined(CONFIG_APP_MOTORS)
+	motors_start(&xform_params);
+#endif
+
 	printk("PWM DONE\n");
 	drv_(enable_capture)(in.dev, in.pwm);
 	while (1) {
 #if defined(CONFIG_500E_MODE_DEV)
-		static int i = 0;
-		
-		i++;
-		if (i > 300)
-			i = 0;
+		static struct profile_gen gen;
+		uint32_t period;
 
-		pwm_set(test.dev, test.pwm, PWM_MSEC(4 * i), PWM_MSEC(3 * i), 0);
+		if (profile_dma) {
+			k_sleep(K_FOREVER);
+			continue;
+		}
 
-		printk("Set %d msec\n", 4*i);
-		k_sleep(K_MSEC(1000));
+		period = profile_next(&gen);
+		output_set(&test, period, CONFIG_APP_PROFILE_PULSE_US);
+		k_sleep(K_USEC(period * CONFIG_APP_PROFILE_REPEAT));
+#elif CONFIG_APP_INPUT_TIMEOUT_MS > 0
+		/*
+		 * Free-running captures with a wide counter only report an
+		 * overflow after a very long time: stop the output ourselves
+		 * once the input has been silent for the configured time.
+		 */
+		uint32_t edges = edge_count;
+
+		k_sleep(K_MSEC(CONFIG_APP_INPUT_TIMEOUT_MS));
+		if (edges == edge_count) {
+			outputs_stop(&out);
+		}
+#else
+		k_sleep(K_FOREVER);
 #endif
 	}
 }
-
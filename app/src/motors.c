@@ -0,0 +1,203 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/shell/shell.h>
+#include <drivers/ic.h>
+
+#include <speedxform/pipeline.h>
+
+#include "app.h"
+#include "motors.h"
+
+#define DT_DRV_COMPAT app_motor
+
+struct motor {
+	struct test_pwm in;
+	struct test_pwm out;
+	uint32_t ratio[2];
+	struct sx_pipeline pipeline;
+	struct motor_stats stats;
+	/* edges at the last input timeout check */
+	uint32_t seen;
+};
+
+#define MOTOR_PIN(node, idx)						\
+	{								\
+		.dev = DEVICE_DT_GET(DT_PWMS_CTLR_BY_IDX(node, idx)),	\
+		.pwm = DT_PWMS_CHANNEL_BY_IDX(node, idx),		\
+		.flags = DT_PWMS_FLAGS_BY_IDX(node, idx),		\
+		.is_ic = DT_NODE_HAS_COMPAT(				\
+			DT_PWMS_CTLR_BY_IDX(node, idx), st_stm32_ic),	\
+	}
+
+#define MOTOR_INIT(inst)						\
+	{								\
+		.in = MOTOR_PIN(DT_DRV_INST(inst), 0),			\
+		.out = MOTOR_PIN(DT_DRV_INST(inst), 1),			\
+		.ratio = COND_CODE_1(DT_INST_NODE_HAS_PROP(inst, ratio),	\
+			(DT_INST_PROP(inst, ratio)),			\
+			({ CONFIG_APP_XFORM_RATIO_NUM,			\
+			   CONFIG_APP_XFORM_RATIO_DEN })),		\
+	},
+
+static struct motor motors[] = {
+	DT_INST_FOREACH_STATUS_OKAY(MOTOR_INIT)
+};
+
+/* Capture goes through the IC driver or through the PWM capture API. */
+static int input_cycles_per_sec(const struct test_pwm *in, uint64_t *cps)
+{
+	if (in->is_ic) {
+		return ic_get_cycles_per_sec(in->dev, in->pwm, cps);
+	}
+
+	return pwm_get_cycles_per_sec(in->dev, in->pwm, cps);
+}
+
+static void motor_capture_callback(const struct device *dev, uint32_t pwm,
+				   uint32_t period_cycles,
+				   uint32_t pulse_cycles, int status,
+				   void *user_data)
+{
+	struct motor *m = user_data;
+	struct sx_output o;
+	uint32_t age;
+
+	if (status != 0) {
+		sx_pipeline_step(&m->pipeline, 0, 0, &o);
+		output_set_cycles(&m->out, 0, 0);
+		m->stats.out_period = 0;
+		m->stats.stops++;
+		return;
+	}
+
+	sx_pipeline_step(&m->pipeline, period_cycles, pulse_cycles, &o);
+	output_set_cycles(&m->out, o.period, o.pulse);
+
+	m->stats.edges++;
+	m->stats.in_period = period_cycles;
+	m->stats.out_period = o.period;
+	if (m->in.is_ic && (ic_get_capture_age(dev, pwm, &age) == 0) &&
+	    (age > m->stats.max_latency)) {
+		m->stats.max_latency = age;
+	}
+}
+
+#if CONFIG_APP_INPUT_TIMEOUT_MS > 0
+static void motors_watch(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(motors); i++) {
+		struct motor *m = &motors[i];
+
+		if ((m->stats.edges == m->seen) && (m->stats.out_period != 0U)) {
+			output_set_cycles(&m->out, 0, 0);
+			m->stats.out_period = 0;
+			m->stats.stops++;
+		}
+		m->seen = m->stats.edges;
+	}
+
+	k_work_reschedule(dwork, K_MSEC(CONFIG_APP_INPUT_TIMEOUT_MS));
+}
+
+static K_WORK_DELAYABLE_DEFINE(watch_work, motors_watch);
+#endif
+
+static int motor_start(struct motor *m, const struct xform_params *params)
+{
+	struct xform_params p = *params;
+	uint64_t cycles_per_sec = 0;
+	int ret;
+
+	if (!device_is_ready(m->in.dev) || !device_is_ready(m->out.dev) ||
+	    (m->ratio[1] == 0U)) {
+		return -ENODEV;
+	}
+
+	ret = input_cycles_per_sec(&m->in, &cycles_per_sec);
+	if (ret < 0) {
+		return ret;
+	}
+
+	p.ratio_num = m->ratio[0];
+	p.ratio_den = m->ratio[1];
+	p.window_cycles = (uint32_t)MIN(CONFIG_APP_XFORM_WINDOW_MS *
+					cycles_per_sec / MSEC_PER_SEC,
+					UINT32_MAX);
+	sx_pipeline_init(&m->pipeline, &p, (uint32_t)cycles_per_sec,
+			 output_hz(&m->out));
+
+	if (m->in.is_ic) {
+		ret = ic_configure_capture(m->in.dev, m->in.pwm,
+					   IC_CAPTURE_MODE_CONTINUOUS |
+					   IC_CAPTURE_TYPE_PERIOD |
+					   PWM_POLARITY_NORMAL,
+					   motor_capture_callback, m);
+		if (ret == 0) {
+			ret = ic_enable_capture(m->in.dev, m->in.pwm);
+		}
+	} else {
+		ret = pwm_configure_capture(m->in.dev, m->in.pwm,
+					    PWM_CAPTURE_MODE_CONTINUOUS |
+					    PWM_CAPTURE_TYPE_PERIOD |
+					    PWM_POLARITY_NORMAL,
+					    motor_capture_callback, m);
+		if (ret == 0) {
+			ret = pwm_enable_capture(m->in.dev, m->in.pwm);
+		}
+	}
+
+	return ret;
+}
+
+int motors_start(const struct xform_params *params)
+{
+	int ret;
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(motors); i++) {
+		ret = motor_start(&motors[i], params);
+		if (ret < 0) {
+			printk("motor %u failed to start (%d)\n", i + 1U, ret);
+			return ret;
+		}
+	}
+
+#if CONFIG_APP_INPUT_TIMEOUT_MS > 0
+	k_work_schedule(&watch_work, K_MSEC(CONFIG_APP_INPUT_TIMEOUT_MS));
+#endif
+
+	return 0;
+}
+
+const struct motor_stats *motors_get_stats(uint32_t idx)
+{
+	if ((idx == 0U) || (idx > ARRAY_SIZE(motors))) {
+		return NULL;
+	}
+
+	return &motors[idx - 1U].stats;
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_motors(const struct shell *sh, size_t argc, char **argv)
+{
+	for (uint32_t i = 0; i < ARRAY_SIZE(motors); i++) {
+		const struct motor_stats *s = &motors[i].stats;
+
+		shell_print(sh, "motor %u: ratio %u/%u edges %u stops %u",
+			    i + 1U, motors[i].ratio[0], motors[i].ratio[1],
+			    s->edges, s->stops);
+		shell_print(sh, "  in %u out %u cycles, max latency %u cycles",
+			    s->in_period, s->out_period, s->max_latency);
+	}
+
+	return 0;
+}
+
+SHELL_CMD_REGISTER(motors, NULL, "Further motor counters", cmd_motors);
+#endif
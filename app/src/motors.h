@@ -0,0 +1,59 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_MOTORS_H_
+#define APP_MOTORS_H_
+
+#include <stdint.h>
+
+#include <speedxform/xform.h>
+
+/**
+ * Further motors.
+ *
+ * Each enabled app-motor devicetree node runs its own capture to output
+ * pipeline next to the one of the app-pwm-ios node, which is motor 0:
+ * separate transform state, ratio and statistics. They share the filter
+ * settings of Kconfig. The optional features (telemetry, black box,
+ * deadline monitor, tuning...) follow motor 0 only.
+ */
+
+/** Counters of a further motor. */
+struct motor_stats {
+	/** Input edges. */
+	uint32_t edges;
+	/** Input stops: capture errors and input timeouts. */
+	uint32_t stops;
+	/** Last input period (capture cycles). */
+	uint32_t in_period;
+	/** Last output period (output cycles), 0 while stopped. */
+	uint32_t out_period;
+	/**
+	 * Largest edge to output latency (capture cycles), only measured
+	 * for inputs served by the IC driver.
+	 */
+	uint32_t max_latency;
+};
+
+/**
+ * Start the capture of the further motors.
+ *
+ * @param params Transform parameters of motor 0, the ratio is replaced by
+ *               the one of each motor.
+ *
+ * @retval 0 If successful.
+ * @retval -errno Negative errno code of the first motor failing to start.
+ */
+int motors_start(const struct xform_params *params);
+
+/**
+ * Counters of a further motor.
+ *
+ * @param idx Motor number, from 1.
+ *
+ * @return The counters, NULL if there is no such motor.
+ */
+const struct motor_stats *motors_get_stats(uint32_t idx);
+
+#endif /* APP_MOTORS_H_ */
@@ -0,0 +1,138 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/dma.h>
+#include <zephyr/drivers/pwm.h>
+
+#include "profile.h"
+
+#define PWM_NODE DT_INST(0, app_pwm_ios)
+
+#define PHASE_MS CONFIG_APP_PROFILE_PHASE_MS
+#define MIN_PERIOD_US CONFIG_APP_PROFILE_MIN_PERIOD_US
+#define MAX_PERIOD_US CONFIG_APP_PROFILE_MAX_PERIOD_US
+
+/* Speed in 1/1000 of the top speed, at which the profile starts and stops. */
+#define MIN_SPEED (1000U * MIN_PERIOD_US / MAX_PERIOD_US)
+
+uint32_t profile_next(struct profile_gen *gen)
+{
+	uint32_t t = gen->t_ms % (3U * PHASE_MS);
+	uint32_t speed;
+	uint32_t period;
+
+	if (t < PHASE_MS) {
+		/* constant acceleration */
+		speed = MIN_SPEED + (1000U - MIN_SPEED) * t / PHASE_MS;
+	} else if (t < 2U * PHASE_MS) {
+		/* cruise, with a slow wobble down to 2% below top speed */
+		t -= PHASE_MS;
+		speed = 980U + 40U * (t < PHASE_MS / 2U ? t : PHASE_MS - t) /
+			PHASE_MS;
+	} else {
+		/* constant braking */
+		t -= 2U * PHASE_MS;
+		speed = 1000U - (1000U - MIN_SPEED) * t / PHASE_MS;
+	}
+
+	period = MIN_PERIOD_US * 1000U / MAX(speed, 1U);
+	period = CLAMP(period, MIN_PERIOD_US, MAX_PERIOD_US);
+
+	gen->t_ms += period * CONFIG_APP_PROFILE_REPEAT / USEC_PER_MSEC;
+
+	return period;
+}
+
+#if DT_NODE_HAS_PROP(PWM_NODE, dmas) && defined(CONFIG_DMA)
+#include <stm32_ll_tim.h>
+
+#define PWM_TEST_CTLR DT_PWMS_CTLR_BY_IDX(PWM_NODE, 3)
+#define TEST_TIMER ((TIM_TypeDef *)DT_REG_ADDR(DT_PARENT(PWM_TEST_CTLR)))
+
+/* Auto-reload values of one whole profile, played in a loop by the DMA. */
+static uint16_t arr_table[CONFIG_APP_PROFILE_LEN];
+
+int profile_dma_start(const struct device *dev, uint32_t channel,
+		      pwm_flags_t flags)
+{
+	const struct device *dma = DEVICE_DT_GET(
+		DT_DMAS_CTLR_BY_NAME(PWM_NODE, profile));
+	struct dma_block_config block = { 0 };
+	struct dma_config config = { 0 };
+	struct profile_gen gen = { 0 };
+	uint64_t cycles_per_sec;
+	uint64_t cycles;
+	size_t len = 0;
+	int ret;
+
+	if (!device_is_ready(dma)) {
+		return -ENODEV;
+	}
+
+	ret = pwm_get_cycles_per_sec(dev, channel, &cycles_per_sec);
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* stop at the end of the braking phase, so that the loop restarts it */
+	while (gen.t_ms < 3U * PHASE_MS) {
+		if (len == ARRAY_SIZE(arr_table)) {
+			return -ENOMEM;
+		}
+
+		cycles = profile_next(&gen) * cycles_per_sec / USEC_PER_SEC;
+		arr_table[len++] = (uint16_t)CLAMP(cycles, 2U, 0x10000U) - 1U;
+	}
+
+	/* fixed pulse width, only the period follows the profile */
+	cycles = CONFIG_APP_PROFILE_PULSE_US * cycles_per_sec / USEC_PER_SEC;
+	ret = pwm_set_cycles(dev, channel, arr_table[0] + 1U,
+			     MAX(cycles, 1U), flags);
+	if (ret < 0) {
+		return ret;
+	}
+
+	block.source_address = (uint32_t)arr_table;
+	block.dest_address = (uint32_t)&TEST_TIMER->ARR;
+	block.block_size = len * sizeof(arr_table[0]);
+	block.source_addr_adj = DMA_ADDR_ADJ_INCREMENT;
+	block.dest_addr_adj = DMA_ADDR_ADJ_NO_CHANGE;
+	block.source_reload_en = 1;
+	block.dest_reload_en = 1;
+
+	config.dma_slot = DT_DMAS_CELL_BY_NAME(PWM_NODE, profile, slot);
+	config.channel_direction = MEMORY_TO_PERIPHERAL;
+	config.source_data_size = sizeof(arr_table[0]);
+	config.dest_data_size = sizeof(arr_table[0]);
+	config.source_burst_length = 1;
+	config.dest_burst_length = 1;
+	config.block_count = 1;
+	config.head_block = &block;
+
+	ret = dma_config(dma, DT_DMAS_CELL_BY_NAME(PWM_NODE, profile, channel),
+			 &config);
+	if (ret < 0) {
+		return ret;
+	}
+
+	ret = dma_start(dma, DT_DMAS_CELL_BY_NAME(PWM_NODE, profile, channel));
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* each update loads the next entry, held for REPEAT periods */
+	LL_TIM_SetRepetitionCounter(TEST_TIMER, CONFIG_APP_PROFILE_REPEAT - 1U);
+	LL_TIM_EnableDMAReq_UPDATE(TEST_TIMER);
+
+	return 0;
+}
+#else
+int profile_dma_start(const struct device *dev, uint32_t channel,
+		      pwm_flags_t flags)
+{
+	return -ENOTSUP;
+}
+#endif
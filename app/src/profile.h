@@ -0,0 +1,53 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_PROFILE_H_
+#define APP_PROFILE_H_
+
+#include <stdint.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/pwm.h>
+
+/** Synthetic ride profile generator state. */
+struct profile_gen {
+	/** Position in the profile (ms). */
+	uint32_t t_ms;
+};
+
+/**
+ * Next period of the synthetic ride profile.
+ *
+ * The profile accelerates from the slowest to the fastest period, cruises,
+ * then brakes back, each phase lasting CONFIG_APP_PROFILE_PHASE_MS. Time
+ * advances by the returned period times CONFIG_APP_PROFILE_REPEAT.
+ *
+ * @param gen Generator state.
+ *
+ * @return Period in usec.
+ */
+uint32_t profile_next(struct profile_gen *gen);
+
+/**
+ * Replay the profile on a PWM output with DMA, without CPU involvement.
+ *
+ * The pulse width is fixed to CONFIG_APP_PROFILE_PULSE_US.
+ *
+ * The timer update event requests a DMA transfer which loads the next
+ * auto-reload value from a circular table holding one whole profile. Each
+ * table entry is held for CONFIG_APP_PROFILE_REPEAT periods through the
+ * repetition counter.
+ *
+ * @param dev PWM device of the test output.
+ * @param channel PWM channel.
+ * @param flags PWM flags.
+ *
+ * @retval 0 If the playback is running.
+ * @retval -ENOTSUP If no DMA is assigned to the test output.
+ * @retval -ENOMEM If the profile does not fit CONFIG_APP_PROFILE_LEN entries.
+ * @retval -errno Other negative errno code on failure.
+ */
+int profile_dma_start(const struct device *dev, uint32_t channel,
+		      pwm_flags_t flags);
+
+#endif /* APP_PROFILE_H_ */
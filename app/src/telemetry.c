@@ -0,0 +1,95 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <codec/period_codec.h>
+
+#include "telemetry.h"
+#if defined(CONFIG_APP_JITTER)
+#include "jitter.h"
+#endif
+
+#define TLM_BUF_SIZE CONFIG_APP_TELEMETRY_BUF_SIZE
+
+/* Frame under construction by the capture callback, the other is printed. */
+struct tlm_frame {
+	uint8_t buf[TLM_BUF_SIZE];
+	size_t len;
+	uint32_t dropped;
+	struct pcodec_state in;
+	struct pcodec_state out;
+};
+
+static struct tlm_frame frames[2];
+static struct tlm_frame *volatile active = &frames[0];
+static uint32_t tlm_seq;
+
+void telemetry_record(uint32_t in, uint32_t out)
+{
+	struct tlm_frame *f = active;
+
+	if (f->len + 2U * PCODEC_MAX_BYTES > sizeof(f->buf)) {
+		f->dropped++;
+		return;
+	}
+
+	f->len += pcodec_encode(&f->in, &f->buf[f->len], in);
+	f->len += pcodec_encode(&f->out, &f->buf[f->len], out);
+}
+
+static void telemetry_thread(void *p1, void *p2, void *p3)
+{
+	for (;;) {
+		struct tlm_frame *f = active;
+		struct tlm_frame *next = (f == &frames[0]) ? &frames[1] :
+							     &frames[0];
+
+		k_sleep(K_MSEC(CONFIG_APP_TELEMETRY_PERIOD_MS));
+
+		next->len = 0U;
+		next->dropped = 0U;
+		next->in.prev = 0U;
+		next->out.prev = 0U;
+
+		/*
+		 * The callback runs in the capture interrupt, never alongside
+		 * this thread: once the pointer is stored, f is ours.
+		 */
+		active = next;
+
+		if ((f->len == 0U) && (f->dropped == 0U)) {
+			continue;
+		}
+
+		printk("TLM %u %u ", tlm_seq++, f->dropped);
+		for (size_t i = 0; i < f->len; i++) {
+			printk("%02x", f->buf[i]);
+		}
+		printk("\n");
+
+#if defined(CONFIG_APP_JITTER)
+		{
+			struct jitter_summary js;
+
+			jitter_get(&js);
+			printk("JIT %u %u %u %u\n", js.samples, js.p50, js.p95,
+			       js.p99);
+		}
+#endif
+	}
+}
+
+K_THREAD_STACK_DEFINE(tlm_stack, CONFIG_APP_TELEMETRY_STACK_SIZE);
+static struct k_thread tlm_thread_data;
+
+void telemetry_init(uint32_t cycles_per_sec)
+{
+	printk("TLM cps=%u\n", cycles_per_sec);
+
+	k_thread_create(&tlm_thread_data, tlm_stack,
+			K_THREAD_STACK_SIZEOF(tlm_stack), telemetry_thread,
+			NULL, NULL, NULL, K_LOWEST_APPLICATION_THREAD_PRIO, 0,
+			K_NO_WAIT);
+	k_thread_name_set(&tlm_thread_data, "telemetry");
+}
@@ -0,0 +1,42 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_TELEMETRY_H_
+#define APP_TELEMETRY_H_
+
+#include <stdint.h>
+
+/**
+ * Period telemetry on the console.
+ *
+ * Input/output period pairs are coded with include/codec/period_codec.h
+ * as they are captured and sent every CONFIG_APP_TELEMETRY_PERIOD_MS as
+ * one line:
+ *
+ *   TLM <seq> <dropped> <hex>
+ *
+ * Each frame starts its deltas from 0, so it decodes on its own. A
+ * "TLM cps=<hz>" line gives the clock of the periods at startup.
+ * With CONFIG_APP_JITTER, each frame is followed by
+ *
+ *   JIT <samples> <p50_ppm> <p95_ppm> <p99_ppm>
+ *
+ * tools/pcodec decodes the console log.
+ */
+
+/**
+ * Start the telemetry.
+ *
+ * @param cycles_per_sec Clock of the recorded periods.
+ */
+void telemetry_init(uint32_t cycles_per_sec);
+
+/**
+ * Queue an input period and the output period computed from it.
+ *
+ * Called from the capture callback only.
+ */
+void telemetry_record(uint32_t in, uint32_t out);
+
+#endif /* APP_TELEMETRY_H_ */
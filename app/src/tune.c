@@ -0,0 +1,243 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/shell/shell.h>
+
+#include "tune.h"
+
+static struct sx_pipeline *pipeline;
+static uint32_t cps;
+
+/* Serializes the writers, the capture callback never takes it. */
+static K_MUTEX_DEFINE(tune_lock);
+static struct xform_params edit;
+
+#if defined(CONFIG_SETTINGS)
+static int tune_settings_set(const char *name, size_t len,
+			     settings_read_cb read_cb, void *cb_arg)
+{
+	struct xform_params params;
+
+	if (!settings_name_steq(name, "params", NULL) ||
+	    (len != sizeof(params))) {
+		return -ENOENT;
+	}
+
+	if (read_cb(cb_arg, &params, sizeof(params)) != sizeof(params)) {
+		return -EIO;
+	}
+
+	return sx_pipeline_set_params(pipeline, &params) ? 0 : -EINVAL;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(xform, "xform", NULL, tune_settings_set, NULL,
+			       NULL);
+#endif
+
+void tune_init(struct sx_pipeline *p, uint32_t cycles_per_sec)
+{
+	pipeline = p;
+	cps = cycles_per_sec;
+
+#if defined(CONFIG_SETTINGS)
+	if ((settings_subsys_init() != 0) ||
+	    (settings_load_subtree("xform") != 0)) {
+		printk("Stored transform not loaded\n");
+	}
+#endif
+}
+
+#if defined(CONFIG_SHELL)
+/* Start an edit of the current parameters, NULL before tune_init(). */
+static struct xform_params *tune_begin(void)
+{
+	if (pipeline == NULL) {
+		return NULL;
+	}
+
+	k_mutex_lock(&tune_lock, K_FOREVER);
+	sx_pipeline_get_params(pipeline, &edit);
+
+	return &edit;
+}
+
+/* Parse a whole number argument, 0x for hexadecimal. */
+static int tune_parse(const struct shell *sh, const char *arg, long min,
+		      long max, long *val)
+{
+	char *end;
+
+	errno = 0;
+	*val = strtol(arg, &end, 0);
+	if ((errno != 0) || (end == arg) || (*end != '\0') || (*val < min) ||
+	    (*val > max)) {
+		shell_error(sh, "invalid value: %s", arg);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* Publish and store the edited parameters. */
+static int tune_end(const struct shell *sh)
+{
+	int ret = 0;
+
+	if (!sx_pipeline_set_params(pipeline, &edit)) {
+		shell_error(sh, "invalid parameters");
+		ret = -EINVAL;
+	}
+#if defined(CONFIG_SETTINGS)
+	else if (settings_save_one("xform/params", &edit, sizeof(edit)) < 0) {
+		shell_warn(sh, "parameters not stored");
+	}
+#endif
+
+	k_mutex_unlock(&tune_lock);
+
+	return ret;
+}
+
+static int cmd_xform(const struct shell *sh, size_t argc, char **argv)
+{
+	struct xform_params params;
+
+	if (pipeline == NULL) {
+		return -EAGAIN;
+	}
+
+	sx_pipeline_get_params(pipeline, &params);
+	shell_print(sh, "ratio %u/%u", params.ratio_num, params.ratio_den);
+	shell_print(sh, "window %u periods, %u ms", params.window,
+		    (uint32_t)((uint64_t)params.window_cycles * MSEC_PER_SEC /
+			       cps));
+	shell_print(sh, "hysteresis %u ppm", params.hysteresis_ppm);
+	shell_print(sh, "gain %d/%d", params.gain, XFORM_GAIN_ONE);
+
+	return 0;
+}
+
+static int cmd_xform_ratio(const struct shell *sh, size_t argc, char **argv)
+{
+	struct xform_params *p;
+	long num, den;
+
+	if ((tune_parse(sh, argv[1], 1, INT32_MAX, &num) < 0) ||
+	    (tune_parse(sh, argv[2], 1, INT32_MAX, &den) < 0)) {
+		return -EINVAL;
+	}
+
+	p = tune_begin();
+	if (p == NULL) {
+		return -EAGAIN;
+	}
+
+	p->ratio_num = (uint32_t)num;
+	p->ratio_den = (uint32_t)den;
+
+	return tune_end(sh);
+}
+
+static int cmd_xform_window(const struct shell *sh, size_t argc, char **argv)
+{
+	struct xform_params *p;
+	long window;
+
+	if (tune_parse(sh, argv[1], 1, XFORM_WINDOW_MAX, &window) < 0) {
+		return -EINVAL;
+	}
+
+	p = tune_begin();
+	if (p == NULL) {
+		return -EAGAIN;
+	}
+
+	p->window = (uint32_t)window;
+
+	return tune_end(sh);
+}
+
+static int cmd_xform_window_ms(const struct shell *sh, size_t argc,
+			       char **argv)
+{
+	struct xform_params *p;
+	uint64_t cycles;
+	long ms;
+
+	if (tune_parse(sh, argv[1], 0, INT32_MAX, &ms) < 0) {
+		return -EINVAL;
+	}
+
+	p = tune_begin();
+	if (p == NULL) {
+		return -EAGAIN;
+	}
+
+	cycles = (uint64_t)ms * cps / MSEC_PER_SEC;
+	p->window_cycles = (uint32_t)MIN(cycles, UINT32_MAX);
+
+	return tune_end(sh);
+}
+
+static int cmd_xform_hysteresis(const struct shell *sh, size_t argc,
+				char **argv)
+{
+	struct xform_params *p;
+	long ppm;
+
+	if (tune_parse(sh, argv[1], 0, XFORM_HYSTERESIS_MAX_PPM, &ppm) < 0) {
+		return -EINVAL;
+	}
+
+	p = tune_begin();
+	if (p == NULL) {
+		return -EAGAIN;
+	}
+
+	p->hysteresis_ppm = (uint32_t)ppm;
+
+	return tune_end(sh);
+}
+
+static int cmd_xform_gain(const struct shell *sh, size_t argc, char **argv)
+{
+	struct xform_params *p;
+	long gain;
+
+	if (tune_parse(sh, argv[1], INT32_MIN, INT32_MAX, &gain) < 0) {
+		return -EINVAL;
+	}
+
+	p = tune_begin();
+	if (p == NULL) {
+		return -EAGAIN;
+	}
+
+	p->gain = (int32_t)gain;
+
+	return tune_end(sh);
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_xform,
+	SHELL_CMD_ARG(ratio, NULL, "Speed ratio: ratio <num> <den>",
+		      cmd_xform_ratio, 3, 0),
+	SHELL_CMD_ARG(window, NULL, "Moving average length (periods)",
+		      cmd_xform_window, 2, 0),
+	SHELL_CMD_ARG(window_ms, NULL,
+		      "Moving average span (ms), 0 to use window",
+		      cmd_xform_window_ms, 2, 0),
+	SHELL_CMD_ARG(hysteresis, NULL, "Ignored output changes (ppm)",
+		      cmd_xform_hysteresis, 2, 0),
+	SHELL_CMD_ARG(gain, NULL, "Predictor gain (1/256)",
+		      cmd_xform_gain, 2, 0),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(xform, &sub_xform, "Speed transform parameters",
+		   cmd_xform);
+#endif
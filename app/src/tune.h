@@ -0,0 +1,29 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_TUNE_H_
+#define APP_TUNE_H_
+
+#include <stdint.h>
+
+#include <speedxform/pipeline.h>
+
+/**
+ * Runtime transform tuning.
+ *
+ * The "xform" shell command changes the parameters of the running
+ * pipeline with sx_pipeline_set_params(): the capture callback picks them
+ * up at the next edge. With CONFIG_SETTINGS they are stored under
+ * "xform/params" and applied again at boot.
+ */
+
+/**
+ * Start tuning a pipeline, applying the stored parameters.
+ *
+ * @param p Pipeline, set up.
+ * @param cycles_per_sec Capture timer clock (Hz), for the time window.
+ */
+void tune_init(struct sx_pipeline *p, uint32_t cycles_per_sec);
+
+#endif /* APP_TUNE_H_ */
@@ -0,0 +1,137 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Duty-cycled capture benchmark: replays a 1 kHz input that steps to 1.25 kHz
+ * halfway through on a RAM backed free-running 32-bit timer, and counts the
+ * capture callbacks with and without IC_CAPTURE_DUTY_CYCLED, along with the
+ * delay until the new period is reported. Time is simulated: the driver ISR
+ * runs once per edge and its re-arm timer is expired by the benchmark.
+ */
+
+/* Without an st,stm32-ic node the driver options cannot come from Kconfig. */
+#define CONFIG_IC_STM32_DUTY_CYCLE 1
+#define CONFIG_IC_STM32_DUTY_CYCLE_BURST 4
+#define CONFIG_IC_STM32_DUTY_CYCLE_MAX_IDLE_MS 64
+#define CONFIG_IC_STM32_DUTY_CYCLE_TOLERANCE_PPM 5000
+
+#include "../../../drivers/ic/ic.c"
+
+#include <string.h>
+#include <zephyr/sys/printk.h>
+
+#define TIM_HZ 64000000u
+#define SIM_MS 10000u
+#define STEP_MS 5000u
+
+/* 1 kHz, then 20 % shorter */
+#define PERIOD_BEFORE (TIM_HZ / 1000u)
+#define PERIOD_AFTER (TIM_HZ / 1250u)
+
+static TIM_TypeDef tim;
+static struct ic_stm32_data data;
+static struct ic_stm32_config cfg = {
+	.timer = &tim,
+	.free_running = true,
+	.overflow_limit = 1u,
+};
+static const struct device fake_ic = {
+	.name = "fake_ic",
+	.config = &cfg,
+	.api = &ic_stm32_driver_api,
+	.data = &data,
+};
+
+/* Simulated time of the edge being handled, in timer cycles. */
+static uint64_t now;
+static uint32_t callbacks;
+/* Time at which the period after the step was first reported, 0 before. */
+static uint64_t seen_at;
+
+static void count_period(const struct device *dev, uint32_t channel,
+			 uint32_t period_cycles, uint32_t pulse_cycles,
+			 int status, void *user_data)
+{
+	uint64_t step_at = (uint64_t)STEP_MS * TIM_HZ / 1000u;
+
+	callbacks++;
+	if ((seen_at == 0u) && (now >= step_at) && (status == 0) &&
+	    (period_cycles >= PERIOD_AFTER - PERIOD_AFTER / 100u) &&
+	    (period_cycles <= PERIOD_AFTER + PERIOD_AFTER / 100u)) {
+		seen_at = now;
+	}
+}
+
+/**
+ * Feed the input edges of SIM_MS to capture channel 1, expiring the re-arm
+ * timer of the driver at its simulated time.
+ */
+static void run_input(void)
+{
+	struct ic_stm32_capture_data *cpt = &data.channel[0].capture;
+	uint64_t end = (uint64_t)SIM_MS * TIM_HZ / 1000u;
+	uint64_t step_at = (uint64_t)STEP_MS * TIM_HZ / 1000u;
+	uint64_t rearm_at = 0u;
+	unsigned int key;
+
+	/* the real re-arm timer is stopped as soon as it is started */
+	key = irq_lock();
+	for (now = PERIOD_BEFORE; now < end;
+	     now += (now < step_at) ? PERIOD_BEFORE : PERIOD_AFTER) {
+		if ((rearm_at != 0u) && (now >= rearm_at)) {
+			ic_stm32_rearm(&cpt->rearm);
+			rearm_at = 0u;
+		}
+
+		if ((uint32_t)now < tim.CNT) {
+			tim.SR |= TIM_SR_UIF;
+		}
+		tim.CNT = (uint32_t)now;
+		tim.CCR1 = (uint32_t)now;
+		tim.SR |= TIM_SR_CC1IF;
+		ic_stm32_isr(&fake_ic);
+
+		if ((rearm_at == 0u) && ((tim.DIER & IC_STM32_CC_BIT(1u)) == 0u)) {
+			k_timer_stop(&cpt->rearm);
+			rearm_at = now + (uint64_t)cpt->idle_ms * TIM_HZ / 1000u;
+		}
+	}
+	irq_unlock(key);
+}
+
+static void bench_input(const char *name, ic_flags_t duty)
+{
+	memset(&tim, 0, sizeof(tim));
+	memset(&data, 0, sizeof(data));
+	tim.cc_channels = 4u;
+	tim.is_32bit = 1u;
+	tim.ARR = UINT32_MAX;
+	data.tim_clk = TIM_HZ;
+	data.cycles_per_sec = TIM_HZ;
+	callbacks = 0u;
+	seen_at = 0u;
+
+	ic_stm32_configure_capture(&fake_ic, 1u, IC_CAPTURE_TYPE_PERIOD |
+				   IC_CAPTURE_MODE_CONTINUOUS | duty,
+				   count_period, NULL);
+	ic_stm32_enable_capture(&fake_ic, 1u);
+	run_input();
+	ic_stm32_disable_capture(&fake_ic, 1u);
+
+	printk("{\"bench\":\"%s\",\"callbacks\":%u,\"step_seen_us\":%u}\n",
+	       name, callbacks,
+	       (seen_at == 0u) ? 0u :
+	       (uint32_t)((seen_at - (uint64_t)STEP_MS * TIM_HZ / 1000u) /
+			  (TIM_HZ / 1000000u)));
+}
+
+void main(void)
+{
+	printk("{\"bench_start\":\"dutycycle\",\"sim_ms\":%u}\n", SIM_MS);
+
+	bench_input("every_edge", 0u);
+	bench_input("duty_cycled", IC_CAPTURE_DUTY_CYCLED);
+
+	printk("{\"bench_done\":true}\n");
+}
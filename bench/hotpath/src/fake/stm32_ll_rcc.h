@@ -0,0 +1,5 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Nothing from the RCC LL is used on the benchmark hot path. */
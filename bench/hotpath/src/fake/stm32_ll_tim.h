@@ -0,0 +1,304 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief RAM backed stand-in for the STM32 TIM registers and LL functions.
+ *
+ * Only what drivers/ic/ic.c uses is provided. Register semantics that matter
+ * to the driver are kept, e.g. SR flags are cleared by writing 0 (rc_w0).
+ */
+
+#ifndef BENCH_FAKE_STM32_LL_TIM_H_
+#define BENCH_FAKE_STM32_LL_TIM_H_
+
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+
+#ifndef __IO
+#define __IO volatile
+#endif
+
+typedef struct {
+	__IO uint32_t CR1;
+	__IO uint32_t CR2;
+	__IO uint32_t SMCR;
+	__IO uint32_t DIER;
+	__IO uint32_t SR;
+	__IO uint32_t EGR;
+	__IO uint32_t CCMR1;
+	__IO uint32_t CCMR2;
+	__IO uint32_t CCER;
+	__IO uint32_t CNT;
+	__IO uint32_t PSC;
+	__IO uint32_t ARR;
+	__IO uint32_t RCR;
+	__IO uint32_t CCR1;
+	__IO uint32_t CCR2;
+	__IO uint32_t CCR3;
+	__IO uint32_t CCR4;
+	/* not a register: selects the 32-bit counter behaviour */
+	uint32_t is_32bit;
+	/* not a register: number of capture/compare channels, e.g. 1 on TIM16 */
+	uint32_t cc_channels;
+} TIM_TypeDef;
+
+#define TIM_SR_UIF	BIT(0)
+#define TIM_SR_CC1IF	BIT(1)
+#define TIM_SR_CC2IF	BIT(2)
+#define TIM_SR_CC3IF	BIT(3)
+#define TIM_SR_CC4IF	BIT(4)
+#define TIM_DIER_UIE	BIT(0)
+
+#define TIM_ICPSC_DIV1	0u
+
+#ifndef SET_BIT
+#define SET_BIT(REG, BIT)	((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT)	((REG) &= ~(BIT))
+#define READ_REG(REG)		((REG))
+#endif
+
+#define IS_TIM_CC1_INSTANCE(INSTANCE) ((INSTANCE)->cc_channels >= 1u)
+#define IS_TIM_CC2_INSTANCE(INSTANCE) ((INSTANCE)->cc_channels >= 2u)
+#define IS_TIM_CC3_INSTANCE(INSTANCE) ((INSTANCE)->cc_channels >= 3u)
+#define IS_TIM_CC4_INSTANCE(INSTANCE) ((INSTANCE)->cc_channels >= 4u)
+#define IS_TIM_BREAK_INSTANCE(INSTANCE) 0
+#define IS_TIM_SLAVE_INSTANCE(INSTANCE) 1
+#define IS_TIM_32B_COUNTER_INSTANCE(INSTANCE) ((INSTANCE)->is_32bit != 0u)
+
+#define SUCCESS 0
+
+#define LL_TIM_ReadReg(INSTANCE, REG) READ_REG((INSTANCE)->REG)
+/* only used on SR, whose flags are cleared by writing 0 */
+#define LL_TIM_WriteReg(INSTANCE, REG, VALUE) ((INSTANCE)->REG &= (VALUE))
+
+#define LL_TIM_CHANNEL_CH1		BIT(0)
+#define LL_TIM_CHANNEL_CH2		BIT(4)
+#define LL_TIM_CHANNEL_CH3		BIT(8)
+#define LL_TIM_CHANNEL_CH4		BIT(12)
+
+#define LL_TIM_IC_FILTER_FDIV1		0u
+#define LL_TIM_ACTIVEINPUT_DIRECTTI	1u
+#define LL_TIM_ACTIVEINPUT_INDIRECTTI	2u
+#define LL_TIM_IC_POLARITY_RISING	0u
+#define LL_TIM_IC_POLARITY_FALLING	1u
+
+#define LL_TIM_OCMODE_FROZEN		0u
+#define LL_TIM_OCMODE_TOGGLE		3u
+#define LL_TIM_OCMODE_FORCED_INACTIVE	4u
+#define LL_TIM_OCMODE_FORCED_ACTIVE	5u
+#define LL_TIM_OCMODE_PWM1		6u
+#define LL_TIM_OCPOLARITY_HIGH		0u
+#define LL_TIM_OCPOLARITY_LOW		1u
+
+#define LL_TIM_UPDATESOURCE_REGULAR	0u
+#define LL_TIM_UPDATESOURCE_COUNTER	1u
+#define LL_TIM_SLAVEMODE_DISABLED	0u
+#define LL_TIM_SLAVEMODE_RESET		4u
+#define LL_TIM_TS_TI1FP1		(5u << 4)
+#define LL_TIM_TS_TI2FP2		(6u << 4)
+#define LL_TIM_CLOCKDIVISION_DIV1	0u
+#define LL_TIM_ICPSC_DIV1		0u
+#define LL_TIM_ICPSC_DIV2		1u
+#define LL_TIM_ICPSC_DIV4		2u
+#define LL_TIM_ICPSC_DIV8		3u
+
+typedef struct {
+	uint32_t ICPolarity;
+	uint32_t ICActiveInput;
+	uint32_t ICPrescaler;
+	uint32_t ICFilter;
+} LL_TIM_IC_InitTypeDef;
+
+typedef struct {
+	uint16_t Prescaler;
+	uint32_t CounterMode;
+	uint32_t Autoreload;
+	uint32_t ClockDivision;
+	uint32_t RepetitionCounter;
+} LL_TIM_InitTypeDef;
+
+static inline void LL_TIM_StructInit(LL_TIM_InitTypeDef *init)
+{
+	*init = (LL_TIM_InitTypeDef){ 0 };
+}
+
+static inline int LL_TIM_Init(TIM_TypeDef *timer, LL_TIM_InitTypeDef *init)
+{
+	timer->PSC = init->Prescaler;
+	timer->ARR = init->Autoreload;
+	return SUCCESS;
+}
+
+static inline void LL_TIM_IC_StructInit(LL_TIM_IC_InitTypeDef *ic)
+{
+	*ic = (LL_TIM_IC_InitTypeDef){ 0 };
+}
+
+static inline int LL_TIM_IC_Init(TIM_TypeDef *timer, uint32_t channel,
+				 LL_TIM_IC_InitTypeDef *ic)
+{
+	ARG_UNUSED(timer);
+	ARG_UNUSED(channel);
+	ARG_UNUSED(ic);
+	return SUCCESS;
+}
+
+static inline void LL_TIM_IC_SetPrescaler(TIM_TypeDef *timer, uint32_t channel,
+					  uint32_t psc)
+{
+	ARG_UNUSED(channel);
+	timer->CCMR1 = psc;
+}
+
+static inline void LL_TIM_EnableCounter(TIM_TypeDef *timer)
+{
+	timer->CR1 |= BIT(0);
+}
+
+static inline void LL_TIM_EnableAllOutputs(TIM_TypeDef *timer)
+{
+	ARG_UNUSED(timer);
+}
+
+static inline void LL_TIM_EnableARRPreload(TIM_TypeDef *timer)
+{
+	timer->CR1 |= BIT(7);
+}
+
+static inline void LL_TIM_EnableUpdateEvent(TIM_TypeDef *timer)
+{
+	timer->CR1 &= ~BIT(1);
+}
+
+static inline void LL_TIM_SetUpdateSource(TIM_TypeDef *timer, uint32_t src)
+{
+	ARG_UNUSED(timer);
+	ARG_UNUSED(src);
+}
+
+static inline void LL_TIM_SetSlaveMode(TIM_TypeDef *timer, uint32_t mode)
+{
+	timer->SMCR = (timer->SMCR & ~7u) | mode;
+}
+
+static inline void LL_TIM_SetTriggerInput(TIM_TypeDef *timer, uint32_t ts)
+{
+	timer->SMCR = (timer->SMCR & ~(7u << 4)) | ts;
+}
+
+static inline void LL_TIM_GenerateEvent_UPDATE(TIM_TypeDef *timer)
+{
+	timer->CNT = 0u;
+}
+
+static inline void LL_TIM_SetAutoReload(TIM_TypeDef *timer, uint32_t arr)
+{
+	timer->ARR = arr;
+}
+
+static inline uint32_t LL_TIM_GetAutoReload(const TIM_TypeDef *timer)
+{
+	return timer->ARR;
+}
+
+static inline void LL_TIM_SetCounter(TIM_TypeDef *timer, uint32_t cnt)
+{
+	timer->CNT = cnt;
+}
+
+static inline uint32_t LL_TIM_GetCounter(const TIM_TypeDef *timer)
+{
+	return timer->CNT;
+}
+
+static inline uint32_t LL_TIM_IsActiveFlag_UPDATE(const TIM_TypeDef *timer)
+{
+	return (timer->SR & TIM_SR_UIF) != 0u;
+}
+
+static inline void LL_TIM_ClearFlag_UPDATE(TIM_TypeDef *timer)
+{
+	timer->SR &= ~TIM_SR_UIF;
+}
+
+static inline void LL_TIM_EnableIT_UPDATE(TIM_TypeDef *timer)
+{
+	timer->DIER |= TIM_DIER_UIE;
+}
+
+static inline void LL_TIM_DisableIT_UPDATE(TIM_TypeDef *timer)
+{
+	timer->DIER &= ~TIM_DIER_UIE;
+}
+
+static inline uint32_t LL_TIM_IsEnabledIT_UPDATE(const TIM_TypeDef *timer)
+{
+	return (timer->DIER & TIM_DIER_UIE) != 0u;
+}
+
+static inline void LL_TIM_CC_EnableChannel(TIM_TypeDef *timer, uint32_t ch)
+{
+	timer->CCER |= ch;
+}
+
+static inline void LL_TIM_CC_DisableChannel(TIM_TypeDef *timer, uint32_t ch)
+{
+	timer->CCER &= ~ch;
+}
+
+static inline uint32_t LL_TIM_CC_IsEnabledChannel(const TIM_TypeDef *timer,
+						  uint32_t ch)
+{
+	return (timer->CCER & ch) == ch;
+}
+
+static inline void LL_TIM_OC_SetMode(TIM_TypeDef *timer, uint32_t ch,
+				     uint32_t mode)
+{
+	ARG_UNUSED(ch);
+	timer->CCMR1 = mode;
+}
+
+static inline void LL_TIM_OC_SetPolarity(TIM_TypeDef *timer, uint32_t ch,
+					 uint32_t polarity)
+{
+	ARG_UNUSED(timer);
+	ARG_UNUSED(ch);
+	ARG_UNUSED(polarity);
+}
+
+static inline void LL_TIM_OC_DisablePreload(TIM_TypeDef *timer, uint32_t ch)
+{
+	ARG_UNUSED(timer);
+	ARG_UNUSED(ch);
+}
+
+static inline void LL_TIM_OC_EnablePreload(TIM_TypeDef *timer, uint32_t ch)
+{
+	ARG_UNUSED(timer);
+	ARG_UNUSED(ch);
+}
+
+static inline void LL_TIM_OC_SetCompareCH1(TIM_TypeDef *timer, uint32_t value)
+{
+	timer->CCR1 = value;
+}
+
+static inline void LL_TIM_OC_SetCompareCH2(TIM_TypeDef *timer, uint32_t value)
+{
+	timer->CCR2 = value;
+}
+
+static inline void LL_TIM_OC_SetCompareCH3(TIM_TypeDef *timer, uint32_t value)
+{
+	timer->CCR3 = value;
+}
+
+static inline void LL_TIM_OC_SetCompareCH4(TIM_TypeDef *timer, uint32_t value)
+{
+	timer->CCR4 = value;
+}
+
+#endif /* BENCH_FAKE_STM32_LL_TIM_H_ */
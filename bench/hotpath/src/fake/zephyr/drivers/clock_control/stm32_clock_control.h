@@ -0,0 +1,26 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Minimal stand-in for the STM32 clock control header. The timer clock is
+ * only read by ic_stm32_init(), which the benchmark never runs: any existing
+ * device will do as clock controller.
+ */
+
+#ifndef BENCH_FAKE_STM32_CLOCK_CONTROL_H_
+#define BENCH_FAKE_STM32_CLOCK_CONTROL_H_
+
+#include <zephyr/drivers/clock_control.h>
+
+#define STM32_CLOCK_CONTROL_NODE DT_CHOSEN(zephyr_console)
+#define STM32_CLOCK_BUS_APB1 2
+#define STM32_APB1_PRESCALER 1
+#define STM32_APB2_PRESCALER 1
+
+struct stm32_pclken {
+	uint32_t bus;
+	uint32_t enr;
+};
+
+#endif /* BENCH_FAKE_STM32_CLOCK_CONTROL_H_ */
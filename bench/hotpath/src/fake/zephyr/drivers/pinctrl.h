@@ -0,0 +1,22 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Minimal stand-in: the benchmark never applies pin configurations. */
+
+#ifndef BENCH_FAKE_PINCTRL_H_
+#define BENCH_FAKE_PINCTRL_H_
+
+#define PINCTRL_STATE_DEFAULT 0U
+
+struct pinctrl_dev_config;
+
+static inline int pinctrl_apply_state(const struct pinctrl_dev_config *config,
+				      uint8_t id)
+{
+	ARG_UNUSED(config);
+	ARG_UNUSED(id);
+	return -ENOTSUP;
+}
+
+#endif /* BENCH_FAKE_PINCTRL_H_ */
@@ -0,0 +1,620 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Hot path benchmark: runs the IC driver interrupt handlers over a RAM backed
+ * fake timer and reports the number of instructions spent per edge, one JSON
+ * object per line.
+ *
+ * Under QEMU -icount every instruction advances the virtual clock by
+ * 2^CONFIG_QEMU_ICOUNT_SHIFT ns, so elapsed virtual time gives instruction
+ * counts independent of the host. The figures exclude the exception entry and
+ * the Zephyr ISR wrapper, which are the same for every configuration.
+ */
+
+#include "../../../drivers/ic/ic.c"
+#include <codec/period_codec.h>
+#include <speedxform/pipeline.h>
+
+#include <string.h>
+#include <zephyr/drivers/pwm.h>
+#include <zephyr/sys/printk.h>
+
+#ifndef CONFIG_QEMU_ICOUNT_SHIFT
+#error The benchmark relies on QEMU icount: build it for a QEMU target
+#endif
+
+#define BENCH_EDGES 4096u
+
+/* 16-bit capture step of a 1.5 kHz edge rate at 48 MHz / 2049 */
+#define STEP_16BIT 15u
+/* 32-bit capture step of the same edge rate at 64 MHz */
+#define STEP_32BIT 42667u
+
+/* Runs of each edge pair when looking for the worst one, see run_worst(). */
+#ifndef BENCH_REPLAYS
+#define BENCH_REPLAYS 64u
+#endif
+
+/*
+ * Edge to output budget of the app (CONFIG_APP_DEADLINE_US) in instructions
+ * on the C031: 200 us at 48 MHz, taking two cycles per instruction for the
+ * flash wait state, the loads and the taken branches.
+ */
+#define BUDGET_US 200u
+#define BUDGET_CPU_MHZ 48u
+#define BUDGET_CYCLES_PER_INSN 2u
+#define BUDGET_INSN (BUDGET_US * BUDGET_CPU_MHZ / BUDGET_CYCLES_PER_INSN)
+
+static TIM_TypeDef tim;
+static struct ic_stm32_data data;
+static struct ic_stm32_config cfg = {
+	.timer = &tim,
+	.overflow_limit = 1u,
+};
+static const struct device fake_ic = {
+	.name = "fake_ic",
+	.config = &cfg,
+	.api = &ic_stm32_driver_api,
+	.data = &data,
+};
+
+/* Timer of the second motor in the dual pipeline benchmark. */
+static TIM_TypeDef tim_b;
+static struct ic_stm32_data data_b;
+static struct ic_stm32_config cfg_b = {
+	.timer = &tim_b,
+	.overflow_limit = 1u,
+};
+static const struct device fake_ic_b = {
+	.name = "fake_ic_b",
+	.config = &cfg_b,
+	.api = &ic_stm32_driver_api,
+	.data = &data_b,
+};
+
+/*
+ * Stand-in for pwm_stm32_set_cycles() of the Zephyr STM32 PWM driver, with
+ * the same checks and register writes over a RAM backed timer. It drives the
+ * output when the capture timer runs in reset mode, as TIM16 does on b500e.
+ */
+struct fake_pwm_config {
+	TIM_TypeDef *timer;
+};
+
+static void (*const set_timer_compare[])(TIM_TypeDef *, uint32_t) = {
+	LL_TIM_OC_SetCompareCH1, LL_TIM_OC_SetCompareCH2,
+	LL_TIM_OC_SetCompareCH3, LL_TIM_OC_SetCompareCH4,
+};
+
+static int fake_pwm_set_cycles(const struct device *dev, uint32_t channel,
+			       uint32_t period_cycles, uint32_t pulse_cycles,
+			       pwm_flags_t flags)
+{
+	const struct fake_pwm_config *pcfg = dev->config;
+	uint32_t ll_channel;
+	uint32_t polarity;
+
+	if ((channel < 1u) || (channel > TIMER_MAX_CH)) {
+		return -EINVAL;
+	}
+
+	if (!IS_TIM_32B_COUNTER_INSTANCE(pcfg->timer) &&
+	    (period_cycles > UINT16_MAX + 1u)) {
+		return -ENOTSUP;
+	}
+
+	ll_channel = ch2ll[channel - 1u];
+
+	if (period_cycles == 0u) {
+		LL_TIM_CC_DisableChannel(pcfg->timer, ll_channel);
+		return 0;
+	}
+
+	polarity = ((flags & PWM_POLARITY_MASK) == PWM_POLARITY_NORMAL) ?
+		   LL_TIM_OCPOLARITY_HIGH : LL_TIM_OCPOLARITY_LOW;
+
+	if (!LL_TIM_CC_IsEnabledChannel(pcfg->timer, ll_channel)) {
+		LL_TIM_OC_SetMode(pcfg->timer, ll_channel, LL_TIM_OCMODE_PWM1);
+		LL_TIM_OC_SetPolarity(pcfg->timer, ll_channel, polarity);
+		set_timer_compare[channel - 1u](pcfg->timer, pulse_cycles);
+		LL_TIM_CC_EnableChannel(pcfg->timer, ll_channel);
+		LL_TIM_EnableARRPreload(pcfg->timer);
+		LL_TIM_OC_EnablePreload(pcfg->timer, ll_channel);
+		LL_TIM_SetAutoReload(pcfg->timer, period_cycles - 1u);
+		LL_TIM_GenerateEvent_UPDATE(pcfg->timer);
+	} else {
+		LL_TIM_OC_SetPolarity(pcfg->timer, ll_channel, polarity);
+		set_timer_compare[channel - 1u](pcfg->timer, pulse_cycles);
+		LL_TIM_SetAutoReload(pcfg->timer, period_cycles - 1u);
+	}
+
+	return 0;
+}
+
+static const struct pwm_driver_api fake_pwm_api = {
+	.set_cycles = fake_pwm_set_cycles,
+};
+
+/* Output timer of the first motor, TIM16 on b500e. */
+static TIM_TypeDef tim_out;
+static const struct fake_pwm_config pwm_cfg = {
+	.timer = &tim_out,
+};
+static const struct device fake_pwm = {
+	.name = "fake_pwm",
+	.config = &pwm_cfg,
+	.api = &fake_pwm_api,
+};
+
+/* Output timer of the second motor, TIM14 with dual_motor.overlay. */
+static TIM_TypeDef tim_out_b;
+static const struct fake_pwm_config pwm_cfg_b = {
+	.timer = &tim_out_b,
+};
+static const struct device fake_pwm_b = {
+	.name = "fake_pwm_b",
+	.config = &pwm_cfg_b,
+	.api = &fake_pwm_api,
+};
+
+/* Output of a pipeline: an IC channel or a PWM channel, as in the app. */
+struct bench_out {
+	const struct device *dev;
+	uint32_t channel;
+	bool is_ic;
+};
+
+/* IC outputs share the free-running capture timer, others use a PWM. */
+static const struct bench_out out_ic = { &fake_ic, 1u, true };
+static const struct bench_out out_pwm = { &fake_pwm, 1u, false };
+static const struct bench_out out_pwm_b = { &fake_pwm_b, 1u, false };
+static const struct bench_out *out_a;
+
+/* Last output update status, checked once the edges are done. */
+static volatile int out_ret;
+static volatile int out_ret_b;
+
+static volatile uint32_t sink;
+
+/* Capture to output pipelines of the app, set up for the timers under test. */
+static struct sx_pipeline pipeline;
+static struct sx_pipeline pipeline_b;
+/* Unscaled second output of the fan-out benchmark. */
+static struct sx_tap tap = {
+	.ratio_num = 1u,
+	.ratio_den = 1u,
+};
+
+typedef void (*bench_isr_t)(const struct device *dev);
+
+/* Mirrors output_set_cycles() of app/src/main.c. */
+static int output_set_cycles(const struct bench_out *out,
+			     uint32_t period_cycles, uint32_t pulse_cycles)
+{
+	if (out->is_ic) {
+		return ic_set_cycles(out->dev, out->channel, period_cycles,
+				     pulse_cycles, 0u);
+	}
+
+	return pwm_set_cycles(out->dev, out->channel, period_cycles,
+			      pulse_cycles, 0u);
+}
+
+static void store_period(const struct device *dev, uint32_t channel,
+			 uint32_t period_cycles, uint32_t pulse_cycles,
+			 int status, void *user_data)
+{
+	sink = period_cycles;
+}
+
+/* Mirrors continuous_capture_callback() of app/src/main.c. */
+static void app_transform(const struct device *dev, uint32_t channel,
+			  uint32_t period_cycles, uint32_t pulse_cycles,
+			  int status, void *user_data)
+{
+	struct sx_output o;
+
+	sx_pipeline_step(&pipeline, (status == 0) ? period_cycles : 0u,
+			 3 * period_cycles / 4, &o);
+	out_ret = output_set_cycles(out_a, o.period, o.pulse);
+}
+
+/* Same with an out-pwms tap on channel 3. */
+static void app_transform_tap(const struct device *dev, uint32_t channel,
+			      uint32_t period_cycles, uint32_t pulse_cycles,
+			      int status, void *user_data)
+{
+	struct sx_output o, t;
+
+	pulse_cycles = 3 * period_cycles / 4;
+	sx_pipeline_step(&pipeline, (status == 0) ? period_cycles : 0u,
+			 pulse_cycles, &o);
+	sx_pipeline_tap(&pipeline, &o, pulse_cycles, &tap, &t);
+	output_set_cycles(&out_ic, o.period, o.pulse);
+	out_ret = ic_set_cycles(dev, 3u, t.period, t.pulse, 0u);
+}
+
+/* Mirrors motor_capture_callback() of app/src/motors.c. */
+static void motor_transform(const struct device *dev, uint32_t channel,
+			    uint32_t period_cycles, uint32_t pulse_cycles,
+			    int status, void *user_data)
+{
+	struct sx_output o;
+	uint32_t age;
+
+	sx_pipeline_step(&pipeline_b, (status == 0) ? period_cycles : 0u,
+			 pulse_cycles, &o);
+	out_ret_b = output_set_cycles(&out_pwm_b, o.period, o.pulse);
+	ic_get_capture_age(dev, channel, &age);
+	sink = age;
+}
+
+/* Stands in for the driver ISR to measure the stimulus loop alone. */
+static __noinline void baseline_isr(const struct device *dev)
+{
+	const struct ic_stm32_config *config = dev->config;
+
+	config->timer->SR = 0u;
+}
+
+static void reset_timer(bool free_running, bool is_32bit)
+{
+	memset(&tim, 0, sizeof(tim));
+	memset(&data, 0, sizeof(data));
+	memset(&tim_out, 0, sizeof(tim_out));
+	tim.is_32bit = is_32bit ? 1u : 0u;
+	tim.cc_channels = 4u;
+	tim.ARR = is_32bit ? UINT32_MAX : 0xffffu;
+	tim_out.cc_channels = 1u;
+	out_a = free_running ? &out_ic : &out_pwm;
+	out_ret = 0;
+	out_ret_b = 0;
+	cfg.free_running = free_running;
+	data.tim_clk = is_32bit ? 64000000u : 48000000u;
+	data.cycles_per_sec = data.tim_clk;
+	sx_pipeline_init(&pipeline, &(struct xform_params)XFORM_PARAMS_DEFAULT,
+			 data.cycles_per_sec, data.cycles_per_sec);
+	tap.out_hz = data.cycles_per_sec;
+}
+
+/**
+ * Feed BENCH_EDGES capture events on @p channel, @p step counter ticks
+ * apart, raising the update flag whenever the counter wraps.
+ *
+ * @return Elapsed virtual time in ns.
+ */
+static uint64_t run_edges(bench_isr_t isr, uint32_t channel, uint32_t step,
+			  bool reset_counter)
+{
+	uint32_t ccr = 0u;
+	uint32_t start, end;
+	unsigned int key;
+
+	key = irq_lock();
+	start = k_cycle_get_32();
+	for (uint32_t i = 0u; i < BENCH_EDGES; i++) {
+		if (reset_counter) {
+			ccr = step;
+		} else {
+			if (ccr > tim.ARR - step) {
+				tim.SR |= TIM_SR_UIF;
+			}
+			ccr = (ccr > tim.ARR - step) ? step - (tim.ARR - ccr) - 1u
+						      : ccr + step;
+		}
+		IC_STM32_CCR(&tim, channel) = ccr;
+		tim.SR |= IC_STM32_CC_BIT(channel);
+		isr(&fake_ic);
+	}
+	end = k_cycle_get_32();
+	irq_unlock(key);
+
+	return k_cyc_to_ns_floor64(end - start);
+}
+
+/**
+ * Feed BENCH_EDGES simultaneous capture events to the reset mode timers of
+ * two motors, the second interrupt pending while the first is handled.
+ *
+ * @return Elapsed virtual time in ns.
+ */
+static uint64_t run_dual_edges(bench_isr_t isr, uint32_t step)
+{
+	uint32_t start, end;
+	unsigned int key;
+
+	key = irq_lock();
+	start = k_cycle_get_32();
+	for (uint32_t i = 0u; i < BENCH_EDGES; i++) {
+		IC_STM32_CCR(&tim, 2u) = step;
+		IC_STM32_CCR(&tim_b, 2u) = step;
+		tim.SR |= IC_STM32_CC_BIT(2u);
+		tim_b.SR |= IC_STM32_CC_BIT(2u);
+		isr(&fake_ic);
+		isr(&fake_ic_b);
+	}
+	end = k_cycle_get_32();
+	irq_unlock(key);
+
+	return k_cyc_to_ns_floor64(end - start);
+}
+
+/* Everything an edge pair changes, to run the same pair again. */
+struct dual_state {
+	TIM_TypeDef tim, tim_b, tim_out, tim_out_b;
+	struct ic_stm32_data data, data_b;
+	struct sx_pipeline pipeline, pipeline_b;
+};
+
+static struct dual_state saved;
+
+static void dual_save(void)
+{
+	saved.tim = tim;
+	saved.tim_b = tim_b;
+	saved.tim_out = tim_out;
+	saved.tim_out_b = tim_out_b;
+	saved.data = data;
+	saved.data_b = data_b;
+	saved.pipeline = pipeline;
+	saved.pipeline_b = pipeline_b;
+}
+
+static void dual_restore(void)
+{
+	tim = saved.tim;
+	tim_b = saved.tim_b;
+	tim_out = saved.tim_out;
+	tim_out_b = saved.tim_out_b;
+	data = saved.data;
+	data_b = saved.data_b;
+	pipeline = saved.pipeline;
+	pipeline_b = saved.pipeline_b;
+}
+
+/* Run the edge pair of the saved state BENCH_REPLAYS times, in ns. */
+static uint64_t run_replays(bench_isr_t isr, uint32_t step)
+{
+	uint32_t start, end;
+
+	start = k_cycle_get_32();
+	for (uint32_t r = 0u; r < BENCH_REPLAYS; r++) {
+		dual_restore();
+		IC_STM32_CCR(&tim, 2u) = step;
+		IC_STM32_CCR(&tim_b, 2u) = step;
+		tim.SR |= IC_STM32_CC_BIT(2u);
+		tim_b.SR |= IC_STM32_CC_BIT(2u);
+		isr(&fake_ic);
+		isr(&fake_ic_b);
+	}
+	end = k_cycle_get_32();
+
+	return k_cyc_to_ns_floor64(end - start);
+}
+
+/**
+ * Feed BENCH_EDGES edge pairs around @p step, timing each one on its own:
+ * the pair is run BENCH_REPLAYS times from the state before it, so that a
+ * coarse system timer still resolves it, and the cost of restoring that state
+ * is taken off with the baseline ISR. The period jitters and steps through
+ * eight speeds so that the transform takes its update paths.
+ *
+ * @return Instructions spent on the worst edge pair.
+ */
+static uint32_t run_worst(uint32_t step)
+{
+	uint64_t base, ns, worst = 0u;
+	unsigned int key;
+
+	key = irq_lock();
+	dual_save();
+	base = run_replays(baseline_isr, step);
+	dual_restore();
+	for (uint32_t i = 0u; i < BENCH_EDGES; i++) {
+		dual_save();
+		/* leaves the state of a single run of the pair behind */
+		ns = run_replays(ic_stm32_isr,
+				 step + ((i >> 8) & 7u) + (i & 1u));
+		if (ns > base) {
+			worst = MAX(worst, ns - base);
+		}
+	}
+	irq_unlock(key);
+
+	return (uint32_t)((worst >> CONFIG_QEMU_ICOUNT_SHIFT) / BENCH_REPLAYS);
+}
+
+/**
+ * Feed BENCH_EDGES compare matches on output @p channel.
+ *
+ * @return Elapsed virtual time in ns.
+ */
+static uint64_t run_matches(bench_isr_t isr, uint32_t channel)
+{
+	uint32_t start, end;
+	unsigned int key;
+
+	key = irq_lock();
+	start = k_cycle_get_32();
+	for (uint32_t i = 0u; i < BENCH_EDGES; i++) {
+		tim.SR |= IC_STM32_CC_BIT(channel);
+		isr(&fake_ic);
+	}
+	end = k_cycle_get_32();
+	irq_unlock(key);
+
+	return k_cyc_to_ns_floor64(end - start);
+}
+
+static uint64_t run_conversions(bool baseline)
+{
+	uint64_t usec = 0u;
+	uint32_t start, end;
+	unsigned int key;
+
+	key = irq_lock();
+	start = k_cycle_get_32();
+	for (uint32_t i = 0u; i < BENCH_EDGES; i++) {
+		if (baseline) {
+			usec = i;
+		} else {
+			ic_cycles_to_usec(&fake_ic, 1u, i, &usec);
+		}
+		sink = (uint32_t)usec;
+	}
+	end = k_cycle_get_32();
+	irq_unlock(key);
+
+	return k_cyc_to_ns_floor64(end - start);
+}
+
+/* Code a cruise-like period stream, as the telemetry does on each edge. */
+static uint64_t run_encode(bool baseline)
+{
+	static uint8_t buf[PCODEC_MAX_BYTES];
+	struct pcodec_state st = { 0 };
+	uint32_t start, end;
+	unsigned int key;
+
+	key = irq_lock();
+	start = k_cycle_get_32();
+	for (uint32_t i = 0u; i < BENCH_EDGES; i++) {
+		uint32_t period = 320000u + (i & 63u);
+
+		if (baseline) {
+			buf[0] = (uint8_t)period;
+		} else {
+			pcodec_encode(&st, buf, period);
+		}
+		sink = buf[0];
+	}
+	end = k_cycle_get_32();
+	irq_unlock(key);
+
+	return k_cyc_to_ns_floor64(end - start);
+}
+
+static void report(const char *name, uint64_t ns, uint64_t baseline_ns)
+{
+	uint64_t insn_x100 = 0u;
+
+	if (ns > baseline_ns) {
+		insn_x100 = ((ns - baseline_ns) >> CONFIG_QEMU_ICOUNT_SHIFT) *
+			    100u / BENCH_EDGES;
+	}
+
+	printk("{\"bench\":\"%s\",\"edges\":%u,\"insn_per_edge\":%u.%02u}\n",
+	       name, BENCH_EDGES, (uint32_t)(insn_x100 / 100u),
+	       (uint32_t)(insn_x100 % 100u));
+}
+
+/* An edge to output figure only counts if the outputs were updated. */
+static void check_output(const char *name)
+{
+	int ret = (out_ret != 0) ? out_ret : out_ret_b;
+
+	if (ret != 0) {
+		printk("{\"bench\":\"%s\",\"error\":%d}\n", name, ret);
+	}
+}
+
+static void bench_capture(const char *name, bool free_running, bool is_32bit,
+			  ic_capture_callback_handler_t cb)
+{
+	uint32_t step = is_32bit ? STEP_32BIT : STEP_16BIT;
+	uint64_t base, ns;
+
+	reset_timer(free_running, is_32bit);
+	base = run_edges(baseline_isr, 2u, step, !free_running);
+
+	ic_stm32_configure_capture(&fake_ic, 2u, IC_CAPTURE_TYPE_PERIOD |
+				   IC_CAPTURE_MODE_CONTINUOUS, cb, NULL);
+	ic_stm32_enable_capture(&fake_ic, 2u);
+	ns = run_edges(ic_stm32_isr, 2u, step, !free_running);
+	ic_stm32_disable_capture(&fake_ic, 2u);
+
+	report(name, ns, base);
+	check_output(name);
+}
+
+/*
+ * Worst case of two motors on the C031: both 16-bit reset mode inputs see
+ * an edge at once and the second output waits for the first one, each
+ * output a PWM timer of its own. The figures are per edge pair: the mean,
+ * then the worst pair against the edge to output budget.
+ */
+static void bench_dual(const char *name)
+{
+	uint64_t base, ns;
+	uint32_t worst;
+
+	reset_timer(false, false);
+	memset(&tim_b, 0, sizeof(tim_b));
+	memset(&data_b, 0, sizeof(data_b));
+	memset(&tim_out_b, 0, sizeof(tim_out_b));
+	tim_b.ARR = 0xffffu;
+	tim_b.cc_channels = 4u;
+	tim_out_b.cc_channels = 1u;
+	data_b.tim_clk = data.tim_clk;
+	data_b.cycles_per_sec = data.cycles_per_sec;
+	sx_pipeline_init(&pipeline_b, &(struct xform_params)XFORM_PARAMS_DEFAULT,
+			 data_b.cycles_per_sec, data_b.cycles_per_sec);
+	base = run_dual_edges(baseline_isr, STEP_16BIT);
+
+	ic_stm32_configure_capture(&fake_ic, 2u, IC_CAPTURE_TYPE_PERIOD |
+				   IC_CAPTURE_MODE_CONTINUOUS, app_transform,
+				   NULL);
+	ic_stm32_configure_capture(&fake_ic_b, 2u, IC_CAPTURE_TYPE_PERIOD |
+				   IC_CAPTURE_MODE_CONTINUOUS, motor_transform,
+				   NULL);
+	ic_stm32_enable_capture(&fake_ic, 2u);
+	ic_stm32_enable_capture(&fake_ic_b, 2u);
+	ns = run_dual_edges(ic_stm32_isr, STEP_16BIT);
+	worst = run_worst(STEP_16BIT);
+	ic_stm32_disable_capture(&fake_ic, 2u);
+	ic_stm32_disable_capture(&fake_ic_b, 2u);
+
+	report(name, ns, base);
+	printk("{\"bench\":\"%s\",\"worst_insn\":%u,\"budget_insn\":%u}\n",
+	       name, worst, BUDGET_INSN);
+	check_output(name);
+}
+
+static void bench_output(const char *name, bool is_32bit)
+{
+	uint64_t base, ns;
+
+	reset_timer(true, is_32bit);
+	base = run_matches(baseline_isr, 1u);
+
+	ic_stm32_set_cycles(&fake_ic, 1u, 10000u, 2500u, 0u);
+	ns = run_matches(ic_stm32_isr, 1u);
+	ic_stm32_set_cycles(&fake_ic, 1u, 0u, 0u, 0u);
+
+	report(name, ns, base);
+}
+
+void main(void)
+{
+	printk("{\"bench_start\":\"hotpath\",\"icount_shift\":%d}\n",
+	       CONFIG_QEMU_ICOUNT_SHIFT);
+
+	bench_capture("capture_reset16", false, false, store_period);
+	bench_capture("capture_free16", true, false, store_period);
+	bench_capture("capture_free32", true, true, store_period);
+	bench_output("output_match16", false);
+	bench_output("output_match32", true);
+
+	reset_timer(false, false);
+	report("cycles_to_usec", run_conversions(false), run_conversions(true));
+	report("pcodec_encode", run_encode(false), run_encode(true));
+
+	bench_capture("edge_to_output_reset16", false, false, app_transform);
+	bench_capture("edge_to_output_free32", true, true, app_transform);
+	bench_capture("edge_to_2outputs_free32", true, true, app_transform_tap);
+	bench_dual("dual_edge_to_output_reset16");
+
+	printk("{\"bench_done\":true}\n");
+}
@@ -31,13 +31,56 @@ LOG_MODULE_REGISTER(ic_stm32, CONFIG_PWM_LOG_LEVEL);
 #define IS_TIM_32B_COUNTER_INSTANCE(INSTANCE) (0)
 #endif
 
+/** Number of capture/compare channels handled by this driver */
+#define IC_MAX_CH 4u
+
 struct ic_stm32_capture_data {
 	ic_capture_callback_handler_t callback;
 	void *user_data;
 	uint32_t period;
 	uint32_t overflows;
+	/**
+	 * Free-running mode: CCR value and update count of the last edge.
+	 * Reset mode: cycles from the last edge to the counter reset.
+	 */
+	uint32_t last_ccr;
+	uint32_t last_wraps;
 	uint8_t skip_irq;
+	/** Input prescaler as log2 of the edges per capture (governor). */
+	uint8_t shift;
 	bool continuous;
+	bool has_last;
+#if defined(CONFIG_IC_STM32_DUTY_CYCLE)
+	bool duty_cycled;
+	/** Periods left in the current burst. */
+	uint8_t burst_left;
+	uint8_t channel;
+	/** Current idle interval between bursts (ms), 0 while unsteady. */
+	uint16_t idle_ms;
+	/** Period range seen in the current burst. */
+	uint32_t burst_min;
+	uint32_t burst_max;
+	const struct device *dev;
+	struct k_timer rearm;
+#endif
+};
+
+/** Output compare channel state (free-running mode only). */
+struct ic_stm32_output_data {
+	uint32_t period;
+	uint32_t pulse;
+	/** Ticks left to wait once the current full counter cycles elapse. */
+	uint32_t remaining;
+	/** Current output level (true while in the pulse). */
+	bool level;
+	/** Whether the next compare match toggles the output. */
+	bool armed;
+};
+
+/* A channel is used either for capture or for output compare. */
+union ic_stm32_channel_data {
+	struct ic_stm32_capture_data capture;
+	struct ic_stm32_output_data output;
 };
 
 /* first capture is always nonsense, second is nonsense when polarity changed */
@@ -47,7 +90,26 @@ struct ic_stm32_capture_data {
 struct ic_stm32_data {
 	/** Timer clock (Hz). */
 	uint32_t tim_clk;
-	struct ic_stm32_capture_data capture;
+	/** Counter clock (Hz), tim_clk divided by the prescaler. */
+	uint32_t cycles_per_sec;
+	/** Timer clock error (ppm), folded into cycles_per_sec. */
+	int32_t cal_ppm;
+#if defined(CONFIG_IC_STM32_GOVERNOR)
+	/** Capture intervals below which the input prescaler is doubled. */
+	uint32_t gov_up_cycles;
+	/** Capture intervals above which the input prescaler is halved. */
+	uint32_t gov_down_cycles;
+#endif
+	/** Number of update events seen so far (free-running mode). */
+	uint32_t wraps;
+	/** Channels with an active capture, bit n - 1 for channel n. */
+	uint8_t capture_mask;
+	/** Channels driven in output compare mode, bit n - 1 for channel n. */
+	uint8_t output_mask;
+	/** Pass-through input and output channels, 0 when inactive. */
+	uint8_t passthrough_in;
+	uint8_t passthrough_out;
+	union ic_stm32_channel_data channel[IC_MAX_CH];
 };
 
 /** PWM configuration. */
@@ -57,10 +119,24 @@ struct ic_stm32_config {
 	uint32_t countermode;
 	struct stm32_pclken pclken;
 	const struct pinctrl_dev_config *pcfg;
+	/** Never reset CNT, compute periods as CCR differences. */
+	bool free_running;
+	/** Counter overflows tolerated between two edges (free-running). */
+	uint32_t overflow_limit;
 
 	void (*irq_config_func)(const struct device *dev);
 };
 
+/*
+ * With IC_DIRECT_CALLS the ic_* inline APIs call the driver functions below
+ * directly, so they need external linkage.
+ */
+#if IC_DIRECT_CALLS
+#define IC_STM32_API
+#else
+#define IC_STM32_API static
+#endif
+
 /** Maximum number of timer channels : some stm32 soc have 6 else only 4 */
 #if defined(LL_TIM_CHANNEL_CH6)
 #define TIMER_HAS_6CH 1
@@ -162,8 +238,40 @@ static int get_tim_clk(const struct stm32_pclken *pclken, uint32_t *tim_clk)
 	return 0;
 }
 
+/** Channel to LL mapping. */
+static const uint32_t ch2ll[IC_MAX_CH] = {
+	LL_TIM_CHANNEL_CH1, LL_TIM_CHANNEL_CH2,
+	LL_TIM_CHANNEL_CH3, LL_TIM_CHANNEL_CH4,
+};
+
+/*
+ * CCxIF/CCxIE occupy bits 1 to 4 of SR/DIER and CCR1 to CCR4 are contiguous,
+ * which lets the ISR address any channel without per-channel LL calls.
+ */
+#define IC_STM32_CC_BIT(channel) (TIM_SR_CC1IF << ((channel) - 1u))
+#define IC_STM32_CC_ALL                                                        \
+	(TIM_SR_CC1IF | TIM_SR_CC2IF | TIM_SR_CC3IF | TIM_SR_CC4IF)
+#define IC_STM32_CCR(timer, channel) ((&(timer)->CCR1)[(channel) - 1u])
+
+static bool is_valid_channel(const struct ic_stm32_config *cfg,
+			     uint32_t channel)
+{
+	switch (channel) {
+	case 1u:
+		return IS_TIM_CC1_INSTANCE(cfg->timer);
+	case 2u:
+		return IS_TIM_CC2_INSTANCE(cfg->timer);
+	case 3u:
+		return IS_TIM_CC3_INSTANCE(cfg->timer);
+	case 4u:
+		return IS_TIM_CC4_INSTANCE(cfg->timer);
+	default:
+		return false;
+	}
+}
+
 static int init_capture_channel(const struct device *dev, uint32_t channel,
-				ic_flags_t flags, uint32_t ll_channel)
+				ic_flags_t flags)
 {
 	const struct ic_stm32_config *cfg = dev->config;
 	bool is_inverted = (flags & PWM_POLARITY_MASK) == PWM_POLARITY_INVERTED;
@@ -172,81 +280,222 @@ static int init_capture_channel(const struct device *dev, uint32_t channel,
 	LL_TIM_IC_StructInit(&ic);
 	ic.ICPrescaler = TIM_ICPSC_DIV1;
 	ic.ICFilter = LL_TIM_IC_FILTER_FDIV1;
+	ic.ICActiveInput = LL_TIM_ACTIVEINPUT_DIRECTTI;
+	ic.ICPolarity = is_inverted ? LL_TIM_IC_POLARITY_FALLING
+			: LL_TIM_IC_POLARITY_RISING;
 
-	if (ll_channel == LL_TIM_CHANNEL_CH1) {
-		if (channel == 1u) {
-			ic.ICActiveInput = LL_TIM_ACTIVEINPUT_DIRECTTI;
-			ic.ICPolarity = is_inverted ? LL_TIM_IC_POLARITY_FALLING
-					: LL_TIM_IC_POLARITY_RISING;
-		} else {
-			ic.ICActiveInput = LL_TIM_ACTIVEINPUT_INDIRECTTI;
-			ic.ICPolarity = is_inverted ? LL_TIM_IC_POLARITY_RISING
-					: LL_TIM_IC_POLARITY_FALLING;
+	if (LL_TIM_IC_Init(cfg->timer, ch2ll[channel - 1u], &ic) != SUCCESS) {
+		LOG_ERR("Could not initialize channel for PWM capture");
+		return -EIO;
+	}
+
+	return 0;
+}
+
+#if defined(CONFIG_IC_STM32_GOVERNOR)
+#define IC_STM32_GOV_MAX_SHIFT                                                 \
+	((CONFIG_IC_STM32_GOVERNOR_MAX_DIV >= 8) ? 3u :                        \
+	 (CONFIG_IC_STM32_GOVERNOR_MAX_DIV >= 4) ? 2u :                        \
+	 (CONFIG_IC_STM32_GOVERNOR_MAX_DIV >= 2) ? 1u : 0u)
+
+/** Input prescaler setting by decimation shift. */
+static const uint32_t shift2icpsc[] = {
+	LL_TIM_ICPSC_DIV1, LL_TIM_ICPSC_DIV2,
+	LL_TIM_ICPSC_DIV4, LL_TIM_ICPSC_DIV8,
+};
+
+static void ic_stm32_governor_limits(struct ic_stm32_data *data)
+{
+	uint64_t up = data->cycles_per_sec / CONFIG_IC_STM32_GOVERNOR_MAX_IRQ_HZ;
+
+	data->gov_up_cycles = (uint32_t)up;
+	data->gov_down_cycles = (uint32_t)MIN(2u * up *
+		(100u + CONFIG_IC_STM32_GOVERNOR_HYSTERESIS) / 100u, UINT32_MAX);
+}
+
+static void ic_stm32_set_decimation(const struct ic_stm32_config *cfg,
+				    struct ic_stm32_capture_data *cpt,
+				    uint32_t channel, uint8_t shift)
+{
+	LL_TIM_IC_SetPrescaler(cfg->timer, ch2ll[channel - 1u],
+			       shift2icpsc[shift]);
+	cpt->shift = shift;
+}
+
+/**
+ * Pick the input prescaler from the last capture interval and normalize
+ * that interval to one edge.
+ */
+static ALWAYS_INLINE uint32_t ic_stm32_govern(const struct device *dev,
+					      struct ic_stm32_capture_data *cpt,
+					      uint32_t channel, uint32_t cycles,
+					      int status)
+{
+	const struct ic_stm32_config *cfg = dev->config;
+	struct ic_stm32_data *data = dev->data;
+	uint8_t shift = cpt->shift;
+
+	if (!cpt->continuous || (channel == data->passthrough_in)) {
+		return cycles;
+	}
+
+	if (status != 0) {
+		/* the input stalled: restart at full resolution */
+		if (shift != 0u) {
+			ic_stm32_set_decimation(cfg, cpt, channel, 0u);
+			cpt->skip_irq = 1u;
 		}
+		return cycles;
+	}
+
+	if ((cycles < data->gov_up_cycles) && (shift < IC_STM32_GOV_MAX_SHIFT)) {
+		ic_stm32_set_decimation(cfg, cpt, channel, shift + 1u);
+	} else if ((cycles > data->gov_down_cycles) && (shift > 0u)) {
+		ic_stm32_set_decimation(cfg, cpt, channel, shift - 1u);
 	} else {
-		if (channel == 1u) {
-			ic.ICActiveInput = LL_TIM_ACTIVEINPUT_INDIRECTTI;
-			ic.ICPolarity = is_inverted ? LL_TIM_IC_POLARITY_RISING
-					: LL_TIM_IC_POLARITY_FALLING;
-		} else {
-			ic.ICActiveInput = LL_TIM_ACTIVEINPUT_DIRECTTI;
-			ic.ICPolarity = is_inverted ? LL_TIM_IC_POLARITY_FALLING
-					: LL_TIM_IC_POLARITY_RISING;
-		}
+		return cycles >> shift;
 	}
 
-	if (LL_TIM_IC_Init(cfg->timer, ll_channel, &ic) != SUCCESS) {
-		LOG_ERR("Could not initialize channel for PWM capture");
-		return -EIO;
+	/* the next capture spans edges counted with both settings */
+	cpt->skip_irq = 1u;
+
+	return cycles >> shift;
+}
+#endif /* CONFIG_IC_STM32_GOVERNOR */
+
+#if defined(CONFIG_IC_STM32_DUTY_CYCLE)
+static void ic_stm32_burst_start(struct ic_stm32_capture_data *cpt,
+				 uint32_t held)
+{
+	cpt->burst_left = CONFIG_IC_STM32_DUTY_CYCLE_BURST;
+	cpt->burst_min = held;
+	cpt->burst_max = held;
+}
+
+static void ic_stm32_rearm(struct k_timer *timer)
+{
+	struct ic_stm32_capture_data *cpt =
+		CONTAINER_OF(timer, struct ic_stm32_capture_data, rearm);
+	const struct ic_stm32_config *cfg = cpt->dev->config;
+	struct ic_stm32_data *data = cpt->dev->data;
+	unsigned int key;
+
+	key = irq_lock();
+	if ((data->capture_mask & BIT(cpt->channel - 1u)) != 0u) {
+		/* captures latched while idle are stale: start a new reference */
+		cpt->has_last = false;
+		ic_stm32_burst_start(cpt, cpt->period);
+		LL_TIM_WriteReg(cfg->timer, SR, ~IC_STM32_CC_BIT(cpt->channel));
+		SET_BIT(cfg->timer->DIER, IC_STM32_CC_BIT(cpt->channel));
 	}
+	irq_unlock(key);
+}
 
-	return 0;
+/**
+ * Account a measured period to the current burst, and go idle at the end of
+ * a steady one.
+ */
+static void ic_stm32_duty_cycle(const struct device *dev,
+				struct ic_stm32_capture_data *cpt,
+				uint32_t channel, int status)
+{
+	const struct ic_stm32_config *cfg = dev->config;
+	bool steady;
+
+	cpt->burst_min = MIN(cpt->burst_min, cpt->period);
+	cpt->burst_max = MAX(cpt->burst_max, cpt->period);
+
+	steady = (status == 0) &&
+		 ((uint64_t)(cpt->burst_max - cpt->burst_min) * 1000000u <=
+		  (uint64_t)cpt->burst_min *
+		  CONFIG_IC_STM32_DUTY_CYCLE_TOLERANCE_PPM);
+
+	if (!steady) {
+		/* sample every edge until the period settles */
+		cpt->idle_ms = 0u;
+		ic_stm32_burst_start(cpt, cpt->period);
+		return;
+	}
+
+	if (--cpt->burst_left != 0u) {
+		return;
+	}
+
+	cpt->idle_ms = MIN(MAX(2u * cpt->idle_ms, 1u),
+			   CONFIG_IC_STM32_DUTY_CYCLE_MAX_IDLE_MS);
+	CLEAR_BIT(cfg->timer->DIER, IC_STM32_CC_BIT(channel));
+	/* no overflow report while idle */
+	cpt->has_last = false;
+	k_timer_start(&cpt->rearm, K_MSEC(cpt->idle_ms), K_NO_WAIT);
 }
+#endif /* CONFIG_IC_STM32_DUTY_CYCLE */
 
-static int ic_stm32_configure_capture(const struct device *dev,
-				       uint32_t channel, ic_flags_t flags,
-				       ic_capture_callback_handler_t cb,
-				       void *user_data)
+IC_STM32_API int ic_stm32_configure_capture(const struct device *dev,
+					    uint32_t channel, ic_flags_t flags,
+					    ic_capture_callback_handler_t cb,
+					    void *user_data)
 {
 
 	/*
-	 * Capture is implemented using the slave mode controller.
-	 * This allows for high accuracy, but only CH1 and CH2 are supported.
-	 * Alternatively all channels could be supported with ISR based resets.
-	 * This is currently not implemented!
+	 * In reset mode the counter is cleared on every captured edge, so
+	 * only one channel can capture at a time and the timer cannot be
+	 * shared with outputs. In free-running mode CNT is never touched and
+	 * any channel can capture while the others capture or drive outputs.
 	 */
 
 	const struct ic_stm32_config *cfg = dev->config;
 	struct ic_stm32_data *data = dev->data;
-	struct ic_stm32_capture_data *cpt = &data->capture;
+	struct ic_stm32_capture_data *cpt;
 	int ret;
 
-	if ((channel != 1u)) {
-		LOG_ERR("PWM capture only supported on first channel");
-		return -ENOTSUP;
+	if (!is_valid_channel(cfg, channel)) {
+		LOG_ERR("Invalid channel (%d)", channel);
+		return -EINVAL;
 	}
 
-	if (LL_TIM_IsEnabledIT_CC1(cfg->timer)) {
+	cpt = &data->channel[channel - 1u].capture;
+
+	if ((data->capture_mask & BIT(channel - 1u)) != 0u) {
 		LOG_ERR("PWM Capture already in progress");
 		return -EBUSY;
 	}
 
+	if ((data->output_mask & BIT(channel - 1u)) != 0u) {
+		LOG_ERR("Channel %d is used as output", channel);
+		return -EBUSY;
+	}
+
 	if (!(flags & IC_CAPTURE_TYPE_PERIOD)) {
 		LOG_ERR("Only Period PWM capture is supported");
 		return -EINVAL;
 	}
 
+	if ((flags & IC_CAPTURE_DUTY_CYCLED) &&
+	    (!IS_ENABLED(CONFIG_IC_STM32_DUTY_CYCLE) || !cfg->free_running ||
+	     !(flags & IC_CAPTURE_MODE_CONTINUOUS))) {
+		LOG_ERR("Duty-cycled capture needs continuous free-running mode");
+		return -ENOTSUP;
+	}
+
 	cpt->callback = cb; /* even if the cb is reset, this is not an error */
 	cpt->user_data = user_data;
 	cpt->continuous = (flags & IC_CAPTURE_MODE_CONTINUOUS) ? true : false;
+#if defined(CONFIG_IC_STM32_DUTY_CYCLE)
+	cpt->duty_cycled = (flags & IC_CAPTURE_DUTY_CYCLED) ? true : false;
+	cpt->dev = dev;
+	cpt->channel = channel;
+	k_timer_init(&cpt->rearm, ic_stm32_rearm, NULL);
+#endif
 
-	ret = init_capture_channel(dev, channel, flags, LL_TIM_CHANNEL_CH1);
+	ret = init_capture_channel(dev, channel, flags);
 	if (ret < 0) {
 		return ret;
 	}
 
-	//LL_TIM_SetTriggerInput(cfg->timer, LL_TIM_TS_TI1FP1);
-	//LL_TIM_SetTriggerInput(cfg->timer, LL_TIM_TS_ITR0);
+	if (cfg->free_running) {
+		/* auto-reload is owned by init, left as is to keep CNT running */
+		return 0;
+	}
 
 	LL_TIM_EnableARRPreload(cfg->timer);
 	if (!IS_TIM_32B_COUNTER_INSTANCE(cfg->timer)) {
@@ -259,129 +508,685 @@ static int ic_stm32_configure_capture(const struct device *dev,
 	return 0;
 }
 
-static int ic_stm32_enable_capture(const struct device *dev, uint32_t channel)
+IC_STM32_API int ic_stm32_enable_capture(const struct device *dev,
+					 uint32_t channel)
 {
 	const struct ic_stm32_config *cfg = dev->config;
 	struct ic_stm32_data *data = dev->data;
+	struct ic_stm32_capture_data *cpt;
+	unsigned int key;
 
-	if ((channel != 1u) && (channel != 2u)) {
-		LOG_ERR("PWM capture only supported on first two channels");
+	if (!is_valid_channel(cfg, channel)) {
+		LOG_ERR("Invalid channel (%d)", channel);
 		return -EINVAL;
 	}
 
-	if (LL_TIM_IsEnabledIT_CC1(cfg->timer)) {
+	cpt = &data->channel[channel - 1u].capture;
+
+	if ((data->capture_mask & BIT(channel - 1u)) != 0u) {
 		LOG_ERR("PWM capture already active");
 		return -EBUSY;
 	}
 
-	if (!data->capture.callback) {
+	if (!cfg->free_running && (data->capture_mask != 0u)) {
+		LOG_ERR("Only one capture at a time without free-running mode");
+		return -EBUSY;
+	}
+
+	if (!cpt->callback) {
 		LOG_ERR("PWM capture not configured");
 		return -EINVAL;
 	}
 
-	data->capture.skip_irq = SKIPPED_IC_CAPTURES;
-	data->capture.overflows = 0u;
-	LL_TIM_ClearFlag_CC1(cfg->timer);
+#if defined(CONFIG_IC_STM32_GOVERNOR)
+	if (cpt->shift != 0u) {
+		ic_stm32_set_decimation(cfg, cpt, channel, 0u);
+	}
+#endif
+	cpt->skip_irq = SKIPPED_IC_CAPTURES;
+	cpt->overflows = 0u;
+	cpt->has_last = false;
+#if defined(CONFIG_IC_STM32_DUTY_CYCLE)
+	cpt->idle_ms = 0u;
+	ic_stm32_burst_start(cpt, UINT32_MAX);
+	cpt->burst_max = 0u;
+#endif
+
+	if (cfg->free_running) {
+		/* update events keep being counted for the other channels */
+		key = irq_lock();
+		data->capture_mask |= BIT(channel - 1u);
+		LL_TIM_WriteReg(cfg->timer, SR, ~IC_STM32_CC_BIT(channel));
+		LL_TIM_CC_EnableChannel(cfg->timer, ch2ll[channel - 1u]);
+		SET_BIT(cfg->timer->DIER, IC_STM32_CC_BIT(channel));
+		irq_unlock(key);
+
+		return 0;
+	}
+
+	data->capture_mask = BIT(channel - 1u);
+	LL_TIM_WriteReg(cfg->timer, SR, ~IC_STM32_CC_BIT(channel));
 	LL_TIM_ClearFlag_UPDATE(cfg->timer);
 
 	//LL_TIM_SetUpdateSource(cfg->timer, LL_TIM_UPDATESOURCE_COUNTER);
-	LL_TIM_EnableIT_CC1(cfg->timer);
+	SET_BIT(cfg->timer->DIER, IC_STM32_CC_BIT(channel));
 	
 	LL_TIM_EnableIT_UPDATE(cfg->timer);
-	LL_TIM_CC_EnableChannel(cfg->timer, LL_TIM_CHANNEL_CH1);
+	LL_TIM_CC_EnableChannel(cfg->timer, ch2ll[channel - 1u]);
 	LL_TIM_GenerateEvent_UPDATE(cfg->timer);
 	
 	return 0;
 }
 
-static int ic_stm32_disable_capture(const struct device *dev, uint32_t channel)
+IC_STM32_API int ic_stm32_disable_capture(const struct device *dev,
+					  uint32_t channel)
 {
 	const struct ic_stm32_config *cfg = dev->config;
+	struct ic_stm32_data *data = dev->data;
+	unsigned int key;
 
-	if ((channel != 1u) && (channel != 2u)) {
-		LOG_ERR("PWM capture only supported on first two channels");
+	if (!is_valid_channel(cfg, channel)) {
+		LOG_ERR("Invalid channel (%d)", channel);
 		return -EINVAL;
 	}
 
-	LL_TIM_SetUpdateSource(cfg->timer, LL_TIM_UPDATESOURCE_REGULAR);
-	LL_TIM_DisableIT_CC1(cfg->timer);
-	LL_TIM_DisableIT_UPDATE(cfg->timer);
-	LL_TIM_CC_DisableChannel(cfg->timer, LL_TIM_CHANNEL_CH1);
+	if ((data->output_mask & BIT(channel - 1u)) != 0u) {
+		LOG_ERR("Channel %d is used as output", channel);
+		return -EINVAL;
+	}
+
+	key = irq_lock();
+	data->capture_mask &= ~BIT(channel - 1u);
+	CLEAR_BIT(cfg->timer->DIER, IC_STM32_CC_BIT(channel));
+	LL_TIM_CC_DisableChannel(cfg->timer, ch2ll[channel - 1u]);
+	irq_unlock(key);
+
+#if defined(CONFIG_IC_STM32_DUTY_CYCLE)
+	if (data->channel[channel - 1u].capture.duty_cycled) {
+		k_timer_stop(&data->channel[channel - 1u].capture.rearm);
+	}
+#endif
+
+	if (!cfg->free_running) {
+		LL_TIM_SetUpdateSource(cfg->timer, LL_TIM_UPDATESOURCE_REGULAR);
+		LL_TIM_DisableIT_UPDATE(cfg->timer);
+	}
 
 	return 0;
 }
 
-static void get_pwm_capture(const struct device *dev, uint32_t channel)
+/**
+ * Program the next compare match of an output channel.
+ *
+ * The match is placed relative to the previous one (@p from), not to CNT, so
+ * the generated edges carry no interrupt latency jitter. Delays longer than
+ * the counter period are split in whole counter cycles during which the
+ * channel matches without toggling.
+ */
+static ALWAYS_INLINE void ic_stm32_schedule_output(const struct ic_stm32_config *cfg,
+						   struct ic_stm32_output_data *out,
+						   uint32_t channel,
+						   uint32_t from)
+{
+	uint32_t arr = LL_TIM_GetAutoReload(cfg->timer);
+
+	if (out->remaining > arr) {
+		out->remaining -= arr + 1u;
+		out->armed = false;
+		LL_TIM_OC_SetMode(cfg->timer, ch2ll[channel - 1u],
+				  LL_TIM_OCMODE_FROZEN);
+		IC_STM32_CCR(cfg->timer, channel) = from;
+		return;
+	}
+
+	if (out->remaining > arr - from) {
+		IC_STM32_CCR(cfg->timer, channel) = out->remaining - (arr - from) - 1u;
+	} else {
+		IC_STM32_CCR(cfg->timer, channel) = from + out->remaining;
+	}
+
+	out->remaining = 0u;
+	if (!out->armed) {
+		out->armed = true;
+		LL_TIM_OC_SetMode(cfg->timer, ch2ll[channel - 1u],
+				  LL_TIM_OCMODE_TOGGLE);
+	}
+}
+
+IC_STM32_API int ic_stm32_set_cycles(const struct device *dev,
+				     uint32_t channel, uint32_t period_cycles,
+				     uint32_t pulse_cycles, ic_flags_t flags)
 {
 	const struct ic_stm32_config *cfg = dev->config;
 	struct ic_stm32_data *data = dev->data;
-	struct ic_stm32_capture_data *cpt = &data->capture;
+	struct ic_stm32_output_data *out;
+	uint32_t ll_channel;
+	unsigned int key;
+
+	if (!cfg->free_running) {
+		LOG_ERR("Outputs require free-running mode");
+		return -ENOTSUP;
+	}
+
+	if (!is_valid_channel(cfg, channel)) {
+		LOG_ERR("Invalid channel (%d)", channel);
+		return -EINVAL;
+	}
+
+	if ((data->capture_mask & BIT(channel - 1u)) != 0u) {
+		LOG_ERR("Channel %d is used for capture", channel);
+		return -EBUSY;
+	}
+
+	if (channel == data->passthrough_out) {
+		LOG_ERR("Channel %d is driven by pass-through", channel);
+		return -EBUSY;
+	}
+
+	if (pulse_cycles > period_cycles) {
+		LOG_ERR("Invalid combination of pulse and period cycles");
+		return -EINVAL;
+	}
 
-	cpt->period = LL_TIM_IC_GetCaptureCH1(cfg->timer);
+	out = &data->channel[channel - 1u].output;
+	ll_channel = ch2ll[channel - 1u];
+
+	key = irq_lock();
+
+	out->period = period_cycles;
+	out->pulse = pulse_cycles;
+
+	if ((pulse_cycles == 0u) || (pulse_cycles == period_cycles)) {
+		/* constant level, no compare interrupt needed */
+		data->output_mask &= ~BIT(channel - 1u);
+		CLEAR_BIT(cfg->timer->DIER, IC_STM32_CC_BIT(channel));
+		LL_TIM_OC_SetMode(cfg->timer, ll_channel,
+				  (pulse_cycles == 0u) ?
+				  LL_TIM_OCMODE_FORCED_INACTIVE :
+				  LL_TIM_OCMODE_FORCED_ACTIVE);
+	} else if ((data->output_mask & BIT(channel - 1u)) == 0u) {
+		/* start from the inactive level, first edge one low phase ahead */
+		LL_TIM_OC_SetMode(cfg->timer, ll_channel,
+				  LL_TIM_OCMODE_FORCED_INACTIVE);
+		LL_TIM_OC_SetPolarity(cfg->timer, ll_channel,
+				      ((flags & PWM_POLARITY_MASK) ==
+				       PWM_POLARITY_INVERTED) ?
+				      LL_TIM_OCPOLARITY_LOW :
+				      LL_TIM_OCPOLARITY_HIGH);
+		LL_TIM_OC_DisablePreload(cfg->timer, ll_channel);
+
+		out->level = false;
+		out->armed = false;
+		out->remaining = period_cycles - pulse_cycles;
+		ic_stm32_schedule_output(cfg, out, channel,
+					 LL_TIM_GetCounter(cfg->timer));
+
+		data->output_mask |= BIT(channel - 1u);
+		LL_TIM_WriteReg(cfg->timer, SR, ~IC_STM32_CC_BIT(channel));
+		SET_BIT(cfg->timer->DIER, IC_STM32_CC_BIT(channel));
+	}
+	/* otherwise the new timings apply from the next output edge */
+
+	LL_TIM_CC_EnableChannel(cfg->timer, ll_channel);
+
+	irq_unlock(key);
+
+	return 0;
 }
 
-static void ic_stm32_isr(const struct device *dev)
+IC_STM32_API int ic_stm32_get_capture_age(const struct device *dev,
+					  uint32_t channel, uint32_t *cycles)
 {
 	const struct ic_stm32_config *cfg = dev->config;
 	struct ic_stm32_data *data = dev->data;
-	struct ic_stm32_capture_data *cpt = &data->capture;
-	int status = 0;
-	uint32_t in_ch = LL_TIM_IsEnabledIT_CC1(cfg->timer) ? 1u : 2u;
-	
-	if (cpt->skip_irq == 0u) {
-		if (LL_TIM_IsActiveFlag_UPDATE(cfg->timer)) {
-			LL_TIM_ClearFlag_UPDATE(cfg->timer);
-			cpt->overflows++;
-			LOG_ERR("counter overflow during PWM capture");
-			status = -ERANGE;
-			if (cpt->callback != NULL) {
-				cpt->callback(dev, in_ch, 0xFFFF,
-					0u,
-					status, cpt->user_data);
-			}
-		}
+	struct ic_stm32_capture_data *cpt;
+	uint32_t cnt, arr;
 
-		if (LL_TIM_IsActiveFlag_CC1(cfg->timer)) {
-			LL_TIM_ClearFlag_CC1(cfg->timer);
+	if (!is_valid_channel(cfg, channel) ||
+	    ((data->capture_mask & BIT(channel - 1u)) == 0u)) {
+		return -EINVAL;
+	}
 
-			get_pwm_capture(dev, in_ch);
+	cpt = &data->channel[channel - 1u].capture;
+	cnt = LL_TIM_GetCounter(cfg->timer);
 
-			
-				
+	if (!cfg->free_running) {
+		*cycles = cnt + cpt->last_ccr;
+	} else {
+		arr = LL_TIM_GetAutoReload(cfg->timer);
+		*cycles = (cnt >= cpt->last_ccr) ? cnt - cpt->last_ccr :
+			  (arr - cpt->last_ccr) + 1u + cnt;
+	}
 
-			if (!cpt->continuous) {
-				ic_stm32_disable_capture(dev, in_ch);
-			} else {
-				cpt->overflows = 0u;
-			}
+	return 0;
+}
+
+IC_STM32_API int ic_stm32_set_passthrough(const struct device *dev,
+					  uint32_t in_channel,
+					  uint32_t out_channel,
+					  uint32_t pulse_cycles)
+{
+	/*
+	 * The input edge resets the counter through the slave controller
+	 * (TI1FP1 or TI2FP2 trigger), and the output channel in PWM mode 1 is
+	 * active from each reset until CCR. CNT no longer runs freely, so
+	 * nothing else may use the timer meanwhile.
+	 */
+
+	const struct ic_stm32_config *cfg = dev->config;
+	struct ic_stm32_data *data = dev->data;
+	uint32_t ll_out;
+	unsigned int key;
+
+	if (!cfg->free_running) {
+		LOG_ERR("Pass-through requires free-running mode");
+		return -ENOTSUP;
+	}
 
-			LL_TIM_SetCounter(cfg->timer, 0);
+	if (!is_valid_channel(cfg, in_channel) ||
+	    !is_valid_channel(cfg, out_channel) ||
+	    (in_channel == out_channel)) {
+		LOG_ERR("Invalid channels (%d, %d)", in_channel, out_channel);
+		return -EINVAL;
+	}
+
+	if (!IS_TIM_SLAVE_INSTANCE(cfg->timer) || (in_channel > 2u)) {
+		LOG_ERR("Channel %d cannot reset the counter", in_channel);
+		return -ENOTSUP;
+	}
+
+	if (((data->capture_mask & ~BIT(in_channel - 1u)) != 0u) ||
+	    ((data->output_mask & ~BIT(out_channel - 1u)) != 0u)) {
+		LOG_ERR("Pass-through needs the timer for itself");
+		return -EBUSY;
+	}
+
+	ll_out = ch2ll[out_channel - 1u];
+
+	key = irq_lock();
+
+	if (pulse_cycles == 0u) {
+		LL_TIM_SetSlaveMode(cfg->timer, LL_TIM_SLAVEMODE_DISABLED);
+		LL_TIM_SetUpdateSource(cfg->timer, LL_TIM_UPDATESOURCE_REGULAR);
+		LL_TIM_OC_SetMode(cfg->timer, ll_out,
+				  LL_TIM_OCMODE_FORCED_INACTIVE);
+		data->passthrough_in = 0u;
+		data->passthrough_out = 0u;
+	} else {
+		data->output_mask &= ~BIT(out_channel - 1u);
+		CLEAR_BIT(cfg->timer->DIER, IC_STM32_CC_BIT(out_channel));
+		IC_STM32_CCR(cfg->timer, out_channel) = pulse_cycles;
+		LL_TIM_OC_SetMode(cfg->timer, ll_out, LL_TIM_OCMODE_PWM1);
+		LL_TIM_CC_EnableChannel(cfg->timer, ll_out);
+
+#if defined(CONFIG_IC_STM32_GOVERNOR)
+		/* the counter resets on every edge, capture them all */
+		ic_stm32_set_decimation(cfg, &data->channel[in_channel - 1u].capture,
+					in_channel, 0u);
+#endif
+
+		/* counter resets must not count as wraps */
+		LL_TIM_SetUpdateSource(cfg->timer, LL_TIM_UPDATESOURCE_COUNTER);
+		LL_TIM_SetTriggerInput(cfg->timer, (in_channel == 1u) ?
+				       LL_TIM_TS_TI1FP1 : LL_TIM_TS_TI2FP2);
+		LL_TIM_SetSlaveMode(cfg->timer, LL_TIM_SLAVEMODE_RESET);
+		data->passthrough_in = in_channel;
+		data->passthrough_out = out_channel;
+	}
+
+	/* the counter origin changed: restart from a new reference edge */
+	data->channel[in_channel - 1u].capture.has_last = false;
+
+	irq_unlock(key);
+
+	return 0;
+}
+
+static ALWAYS_INLINE int ic_stm32_handle_update(const struct device *dev)
+{
+	const struct ic_stm32_config *cfg = dev->config;
+	struct ic_stm32_data *data = dev->data;
+	struct ic_stm32_capture_data *cpt;
+	uint32_t in_ch;
 
+	if (!LL_TIM_IsActiveFlag_UPDATE(cfg->timer)) {
+		return 0;
+	}
+
+	if (cfg->free_running) {
+		/* counted before the flag clears, never seen as neither */
+		data->wraps++;
+		LL_TIM_ClearFlag_UPDATE(cfg->timer);
+
+		/* report inputs that stayed silent beyond the overflow limit */
+		for (in_ch = 1u; in_ch <= IC_MAX_CH; in_ch++) {
+			cpt = &data->channel[in_ch - 1u].capture;
+			if (((data->capture_mask & BIT(in_ch - 1u)) == 0u) ||
+			    !cpt->has_last ||
+			    ((data->wraps - cpt->last_wraps) <=
+			     cfg->overflow_limit)) {
+				continue;
+			}
+
+			cpt->has_last = false;
+			cpt->overflows = data->wraps - cpt->last_wraps;
 			if (cpt->callback != NULL) {
-				cpt->callback(dev, in_ch, cpt->period,
+				cpt->callback(dev, in_ch,
+					LL_TIM_GetAutoReload(cfg->timer),
 					0u,
-					status, cpt->user_data);
+					-ERANGE, cpt->user_data);
 			}
 		}
+		return 0;
+	}
+
+	LL_TIM_ClearFlag_UPDATE(cfg->timer);
+
+	if (data->capture_mask == 0u) {
+		return 0;
+	}
+
+	in_ch = u32_count_trailing_zeros(data->capture_mask) + 1u;
+	cpt = &data->channel[in_ch - 1u].capture;
+	if (cpt->skip_irq != 0u) {
+		return 0;
+	}
+
+	cpt->overflows++;
+	LOG_ERR("counter overflow during PWM capture");
+	if (cpt->callback != NULL) {
+		cpt->callback(dev, in_ch, 0xFFFF,
+			0u,
+			-ERANGE, cpt->user_data);
+	}
+
+	return -ERANGE;
+}
+
+static ALWAYS_INLINE void ic_stm32_capture_reset(const struct device *dev,
+						 uint32_t in_ch, int status)
+{
+	const struct ic_stm32_config *cfg = dev->config;
+	struct ic_stm32_data *data = dev->data;
+	struct ic_stm32_capture_data *cpt = &data->channel[in_ch - 1u].capture;
+
+	if (cpt->skip_irq != 0u) {
+		/* still restart the count, the next period must be whole */
+		cpt->skip_irq--;
+		LL_TIM_SetCounter(cfg->timer, 0);
+		return;
+	}
+
+	cpt->period = IC_STM32_CCR(cfg->timer, in_ch);
+
+	if (!cpt->continuous) {
+		ic_stm32_disable_capture(dev, in_ch);
 	} else {
-		if (LL_TIM_IsActiveFlag_UPDATE(cfg->timer)) {
-			LL_TIM_ClearFlag_UPDATE(cfg->timer);
+		cpt->overflows = 0u;
+	}
+
+	/* kept for ic_get_capture_age(): CNT no longer counts from the edge */
+	cpt->last_ccr = LL_TIM_GetCounter(cfg->timer) - cpt->period;
+	LL_TIM_SetCounter(cfg->timer, 0);
+#if defined(CONFIG_IC_STM32_GOVERNOR)
+	cpt->period = ic_stm32_govern(dev, cpt, in_ch, cpt->period, status);
+#endif
+
+	if (cpt->callback != NULL) {
+		cpt->callback(dev, in_ch, cpt->period,
+			0u,
+			status, cpt->user_data);
+	}
+}
+
+static ALWAYS_INLINE void ic_stm32_capture_free_running(const struct device *dev,
+							uint32_t in_ch)
+{
+	const struct ic_stm32_config *cfg = dev->config;
+	struct ic_stm32_data *data = dev->data;
+	struct ic_stm32_capture_data *cpt = &data->channel[in_ch - 1u].capture;
+	uint32_t ccr = IC_STM32_CCR(cfg->timer, in_ch);
+	uint32_t arr = LL_TIM_GetAutoReload(cfg->timer);
+	uint32_t wraps = data->wraps;
+	/* with pass-through, the edge also resets the counter in hardware */
+	uint32_t ref = (in_ch == data->passthrough_in) ? 0u : ccr;
+	uint32_t overflows;
+	uint64_t period;
+	int status = 0;
+
+	/*
+	 * A pending update with a small capture value means the counter wrapped
+	 * before this edge but the wrap has not been accounted for yet.
+	 */
+	if (LL_TIM_IsActiveFlag_UPDATE(cfg->timer) && (ccr <= (arr >> 1))) {
+		wraps++;
+	}
+
+	overflows = wraps - cpt->last_wraps;
+	cpt->last_wraps = wraps;
+
+	if (cpt->skip_irq != 0u) {
+		cpt->skip_irq--;
+		cpt->last_ccr = ref;
+		return;
+	}
+
+	if (!cpt->has_last) {
+		/* first edge only provides the reference */
+		cpt->has_last = true;
+		cpt->last_ccr = ref;
+		return;
+	}
+
+	if (overflows == 0u) {
+		cpt->period = ccr - cpt->last_ccr;
+	} else if ((overflows == 1u) && (ccr < cpt->last_ccr)) {
+		cpt->period = (arr - cpt->last_ccr) + 1u + ccr;
+	} else {
+		period = (uint64_t)overflows * ((uint64_t)arr + 1u) + ccr -
+			 cpt->last_ccr;
+		if ((overflows > cfg->overflow_limit) || (period > UINT32_MAX)) {
+			status = -ERANGE;
+			period = arr;
 		}
+		cpt->period = (uint32_t)period;
+	}
+
+	cpt->overflows = overflows;
+	cpt->last_ccr = ref;
+#if defined(CONFIG_IC_STM32_GOVERNOR)
+	cpt->period = ic_stm32_govern(dev, cpt, in_ch, cpt->period, status);
+#endif
+#if defined(CONFIG_IC_STM32_DUTY_CYCLE)
+	if (cpt->duty_cycled) {
+		ic_stm32_duty_cycle(dev, cpt, in_ch, status);
+	}
+#endif
+
+	if (!cpt->continuous) {
+		ic_stm32_disable_capture(dev, in_ch);
+	}
 
-		if (LL_TIM_IsActiveFlag_CC1(cfg->timer)) {
-			LL_TIM_ClearFlag_CC1(cfg->timer);
-			cpt->skip_irq--;
+	if (cpt->callback != NULL) {
+		cpt->callback(dev, in_ch, cpt->period,
+			0u,
+			status, cpt->user_data);
+	}
+}
+
+static ALWAYS_INLINE void ic_stm32_output_match(const struct device *dev,
+						uint32_t channel)
+{
+	const struct ic_stm32_config *cfg = dev->config;
+	struct ic_stm32_data *data = dev->data;
+	struct ic_stm32_output_data *out = &data->channel[channel - 1u].output;
+
+	if (out->armed) {
+		out->level = !out->level;
+		out->remaining = out->level ? out->pulse
+				 : out->period - out->pulse;
+	}
+
+	ic_stm32_schedule_output(cfg, out, channel,
+				 IC_STM32_CCR(cfg->timer, channel));
+}
+
+/*
+ * In reset mode a capture serviced together with a pending update spans a
+ * counter overflow, so it carries the -ERANGE status of that update.
+ */
+static ALWAYS_INLINE void ic_stm32_handle_capture(const struct device *dev,
+						  int status)
+{
+	const struct ic_stm32_config *cfg = dev->config;
+	struct ic_stm32_data *data = dev->data;
+	uint32_t pending;
+	uint32_t ch;
+
+	pending = LL_TIM_ReadReg(cfg->timer, SR) &
+		  LL_TIM_ReadReg(cfg->timer, DIER) & IC_STM32_CC_ALL;
+
+	for (ch = 1u; (pending != 0u) && (ch <= IC_MAX_CH); ch++) {
+		if ((pending & IC_STM32_CC_BIT(ch)) == 0u) {
+			continue;
+		}
+
+		pending &= ~IC_STM32_CC_BIT(ch);
+		LL_TIM_WriteReg(cfg->timer, SR, ~IC_STM32_CC_BIT(ch));
+
+		if ((data->output_mask & BIT(ch - 1u)) != 0u) {
+			ic_stm32_output_match(dev, ch);
+		} else if (cfg->free_running) {
+			ic_stm32_capture_free_running(dev, ch);
+		} else {
+			ic_stm32_capture_reset(dev, ch, status);
 		}
 	}
 }
 
-static int ic_stm32_get_cycles_per_sec(const struct device *dev,
-					uint32_t channel, uint64_t *cycles)
+/*
+ * Timers with split interrupt lines (e.g. TIM1 "brk_up_trg_com" and "cc" on
+ * STM32C0 and STM32G0) run this handler from both vectors, whichever comes
+ * first services both events.
+ */
+static void ic_stm32_isr(const struct device *dev)
+{
+	const struct ic_stm32_config *cfg = dev->config;
+
+	if (cfg->free_running) {
+		/*
+		 * Captures first: a capture tells a wrap before its edge from one
+		 * after it by the update flag, which must still be pending.
+		 */
+		ic_stm32_handle_capture(dev, 0);
+		(void)ic_stm32_handle_update(dev);
+	} else {
+		ic_stm32_handle_capture(dev, ic_stm32_handle_update(dev));
+	}
+}
+
+IC_STM32_API int ic_stm32_get_cycles_per_sec(const struct device *dev,
+					     uint32_t channel,
+					     uint64_t *cycles)
+{
+	struct ic_stm32_data *data = dev->data;
+
+	*cycles = (uint64_t)data->cycles_per_sec;
+
+	return 0;
+}
+
+/** Counter clock for a timer clock, corrected by the calibration. */
+static uint32_t ic_stm32_rate(const struct ic_stm32_config *cfg,
+			      const struct ic_stm32_data *data,
+			      uint32_t tim_clk)
+{
+	uint64_t cps = tim_clk / (cfg->prescaler + 1u);
+
+	return (uint32_t)(cps * (uint32_t)(1000000 + data->cal_ppm) / 1000000u);
+}
+
+static inline uint32_t rescale(uint32_t cycles, uint32_t from, uint32_t to)
+{
+	return (uint32_t)MIN((uint64_t)cycles * to / from, UINT32_MAX);
+}
+
+IC_STM32_API int ic_stm32_clock_changed(const struct device *dev)
 {
+	const struct ic_stm32_config *cfg = dev->config;
 	struct ic_stm32_data *data = dev->data;
+	uint32_t tim_clk, old, cps;
+	unsigned int key;
+	int r;
+
+	r = get_tim_clk(&cfg->pclken, &tim_clk);
+	if (r < 0) {
+		LOG_ERR("Could not obtain timer clock (%d)", r);
+		return r;
+	}
+
+	cps = ic_stm32_rate(cfg, data, tim_clk);
+
+	key = irq_lock();
+
+	old = data->cycles_per_sec;
+	data->tim_clk = tim_clk;
+	data->cycles_per_sec = cps;
+#if defined(CONFIG_IC_STM32_GOVERNOR)
+	ic_stm32_governor_limits(data);
+#endif
+
+	if (old != cps) {
+		for (uint32_t ch = 1u; ch <= IC_MAX_CH; ch++) {
+			union ic_stm32_channel_data *chd = &data->channel[ch - 1u];
+
+			if ((data->capture_mask & BIT(ch - 1u)) != 0u) {
+				/* the period in progress spans both clocks */
+				chd->capture.skip_irq = 1u;
+			} else if ((data->output_mask & BIT(ch - 1u)) != 0u) {
+				chd->output.period =
+					rescale(chd->output.period, old, cps);
+				chd->output.pulse =
+					rescale(chd->output.pulse, old, cps);
+				chd->output.remaining =
+					rescale(chd->output.remaining, old, cps);
+			} else if (ch == data->passthrough_out) {
+				IC_STM32_CCR(cfg->timer, ch) =
+					rescale(IC_STM32_CCR(cfg->timer, ch),
+						old, cps);
+			}
+		}
+	}
+
+	irq_unlock(key);
+
+	return 0;
+}
+
+IC_STM32_API int ic_stm32_set_calibration(const struct device *dev,
+					  int32_t ppm)
+{
+	/*
+	 * The counter keeps running from the same clock: only its known rate
+	 * changes, so outputs and captures in progress stay as they are.
+	 */
+
 	const struct ic_stm32_config *cfg = dev->config;
+	struct ic_stm32_data *data = dev->data;
+	unsigned int key;
+
+	if ((ppm <= -1000000) || (ppm >= 1000000)) {
+		LOG_ERR("Invalid clock correction (%d ppm)", ppm);
+		return -EINVAL;
+	}
 
-	*cycles = (uint64_t)(data->tim_clk / (cfg->prescaler + 1));
+	key = irq_lock();
+	data->cal_ppm = ppm;
+	data->cycles_per_sec = ic_stm32_rate(cfg, data, data->tim_clk);
+#if defined(CONFIG_IC_STM32_GOVERNOR)
+	ic_stm32_governor_limits(data);
+#endif
+	irq_unlock(key);
 
 	return 0;
 }
@@ -392,6 +1197,13 @@ static const struct ic_driver_api ic_stm32_driver_api = {
 	.configure_capture = ic_stm32_configure_capture,
 	.enable_capture = ic_stm32_enable_capture,
 	.disable_capture = ic_stm32_disable_capture,
+
+	.set_cycles = ic_stm32_set_cycles,
+
+	.get_capture_age = ic_stm32_get_capture_age,
+	.set_passthrough = ic_stm32_set_passthrough,
+	.clock_changed = ic_stm32_clock_changed,
+	.set_calibration = ic_stm32_set_calibration,
 };
 
 static int ic_stm32_init(const struct device *dev)
@@ -422,6 +1234,10 @@ static int ic_stm32_init(const struct device *dev)
 		LOG_ERR("Could not obtain timer clock (%d)", r);
 		return r;
 	}
+	data->cycles_per_sec = ic_stm32_rate(cfg, data, data->tim_clk);
+#if defined(CONFIG_IC_STM32_GOVERNOR)
+	ic_stm32_governor_limits(data);
+#endif
 
 	/* configure pinmux */
 	r = pinctrl_apply_state(cfg->pcfg, PINCTRL_STATE_DEFAULT);
@@ -435,7 +1251,13 @@ static int ic_stm32_init(const struct device *dev)
 
 	init.Prescaler = cfg->prescaler;
 	init.CounterMode = cfg->countermode;
-	init.Autoreload = 0u;
+	if (!cfg->free_running) {
+		init.Autoreload = 0u;
+	} else if (!IS_TIM_32B_COUNTER_INSTANCE(cfg->timer)) {
+		init.Autoreload = 0xffffu;
+	} else {
+		init.Autoreload = 0xffffffffu;
+	}
 	init.ClockDivision = LL_TIM_CLOCKDIVISION_DIV1;
 
 	if (LL_TIM_Init(cfg->timer, &init) != SUCCESS) {
@@ -450,6 +1272,12 @@ static int ic_stm32_init(const struct device *dev)
 	}
 #endif
 
+	if (cfg->free_running) {
+		/* update events are counted for as long as the timer runs */
+		LL_TIM_ClearFlag_UPDATE(cfg->timer);
+		LL_TIM_EnableIT_UPDATE(cfg->timer);
+	}
+
 	LL_TIM_EnableCounter(cfg->timer);
 
 	cfg->irq_config_func(dev);
@@ -457,13 +1285,49 @@ static int ic_stm32_init(const struct device *dev)
 	return 0;
 }
 
+#define IC_STM32_IRQ_CONNECT(index, irqn, prio, isr)                          \
+	do {                                                                   \
+		IRQ_CONNECT(irqn, prio, isr, DEVICE_DT_INST_GET(index), 0);    \
+		irq_enable(irqn);                                              \
+	} while (false)
+
+/* Update interrupt name: "up", or the combined upstream STM32 name. */
+#define IC_STM32_UP_IRQ(index, cell)                                           \
+	COND_CODE_1(DT_IRQ_HAS_NAME(DT_INST_PARENT(index), up),                \
+		(DT_IRQ_BY_NAME(DT_INST_PARENT(index), up, cell)),             \
+		(DT_IRQ_BY_NAME(DT_INST_PARENT(index), brk_up_trg_com, cell)))
+
+/*
+ * Advanced timers expose separate "cc" and update interrupts, other timers
+ * have a single global interrupt. Both vectors share the wrap count, the
+ * channel state and the callbacks: at equal priorities neither preempts the
+ * other, so the handler needs no lock and callbacks are never reentered.
+ */
+#define IC_STM32_IRQ_CONNECT_SPLIT(index)                                      \
+	BUILD_ASSERT(DT_IRQ_BY_NAME(DT_INST_PARENT(index), cc, priority) ==    \
+		     IC_STM32_UP_IRQ(index, priority),                         \
+		     "IC cc and update interrupts need equal priorities");     \
+	IC_STM32_IRQ_CONNECT(index,                                            \
+		DT_IRQ_BY_NAME(DT_INST_PARENT(index), cc, irq),                \
+		DT_IRQ_BY_NAME(DT_INST_PARENT(index), cc, priority),           \
+		ic_stm32_isr);                                                 \
+	IC_STM32_IRQ_CONNECT(index,                                            \
+		IC_STM32_UP_IRQ(index, irq),                                   \
+		IC_STM32_UP_IRQ(index, priority),                              \
+		ic_stm32_isr)
+
+#define IC_STM32_IRQ_CONNECT_GLOBAL(index)                                     \
+	IC_STM32_IRQ_CONNECT(index,                                            \
+		DT_IRQN(DT_INST_PARENT(index)),                                \
+		DT_IRQ(DT_INST_PARENT(index), priority),                       \
+		ic_stm32_isr)
+
 #define IRQ_CONFIG_FUNC(index)                                                 \
 static void ic_stm32_irq_config_func_##index(const struct device *dev)        \
 {                                                                              \
-	IRQ_CONNECT(DT_IRQN(DT_INST_PARENT(index)),                            \
-			DT_IRQ(DT_INST_PARENT(index), priority),               \
-			ic_stm32_isr, DEVICE_DT_INST_GET(index), 0);          \
-	irq_enable(DT_IRQN(DT_INST_PARENT(index)));                            \
+	COND_CODE_1(DT_IRQ_HAS_NAME(DT_INST_PARENT(index), cc),                \
+		(IC_STM32_IRQ_CONNECT_SPLIT(index)),                           \
+		(IC_STM32_IRQ_CONNECT_GLOBAL(index)));                         \
 }
 #define CAPTURE_INIT(index)                                                    \
 	.irq_config_func = ic_stm32_irq_config_func_##index
@@ -486,6 +1350,8 @@ static void ic_stm32_irq_config_func_##index(const struct device *dev)        \
 		.countermode = DT_PROP(DT_INST_PARENT(index), st_countermode), \
 		.pclken = DT_INST_CLK(index, timer),                           \
 		.pcfg = PINCTRL_DT_INST_DEV_CONFIG_GET(index),		       \
+		.free_running = DT_INST_PROP(index, free_running),	       \
+		.overflow_limit = DT_INST_PROP(index, overflow_limit),	       \
 		CAPTURE_INIT(index)					       \
 	};                                                                     \
 									       \
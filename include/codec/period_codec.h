@@ -0,0 +1,189 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Delta/zigzag varint codec for period streams
+ *
+ * Successive periods differ little, so each value is coded as the zigzag
+ * mapped difference to the previous one, in unsigned LEB128: 7 bits per
+ * byte, least significant group first, bit 7 set on all bytes but the last.
+ * Steady periods then take one byte instead of four.
+ *
+ * Plain C, no allocation and no Zephyr dependency: the firmware (telemetry,
+ * black-box recorder) and the host tools share this header, so the format
+ * is defined in one place.
+ */
+
+#ifndef PERIOD_CODEC_H_
+#define PERIOD_CODEC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Longest coding of a 32-bit value. */
+#define PCODEC_MAX_BYTES 5U
+
+/** Longest coding of a 64-bit value. */
+#define PCODEC_MAX_BYTES64 10U
+
+/** Delta coder state, one per stream. Zero initialized. */
+struct pcodec_state {
+	uint32_t prev;
+};
+
+static inline uint32_t pcodec_zigzag(int32_t v)
+{
+	return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t pcodec_unzigzag(uint32_t v)
+{
+	return (int32_t)((v >> 1) ^ (0U - (v & 1U)));
+}
+
+/** Bytes taken by the varint coding of @p v. */
+static inline size_t pcodec_varint_len(uint32_t v)
+{
+	size_t len = 1U;
+
+	while (v >= 0x80U) {
+		v >>= 7;
+		len++;
+	}
+
+	return len;
+}
+
+/**
+ * Write the varint coding of @p v.
+ *
+ * @param buf Output, at least PCODEC_MAX_BYTES long.
+ *
+ * @return Bytes written.
+ */
+static inline size_t pcodec_varint_put(uint8_t *buf, uint32_t v)
+{
+	size_t len = 0U;
+
+	while (v >= 0x80U) {
+		buf[len++] = (uint8_t)v | 0x80U;
+		v >>= 7;
+	}
+	buf[len++] = (uint8_t)v;
+
+	return len;
+}
+
+/**
+ * Read a varint.
+ *
+ * @return Bytes read, 0 if @p buf is truncated or the value overflows.
+ */
+static inline size_t pcodec_varint_get(const uint8_t *buf, size_t len,
+				       uint32_t *v)
+{
+	uint32_t val = 0U;
+
+	for (size_t i = 0U; (i < len) && (i < PCODEC_MAX_BYTES); i++) {
+		val |= (uint32_t)(buf[i] & 0x7fU) << (7U * i);
+		if ((buf[i] & 0x80U) == 0U) {
+			if ((i == PCODEC_MAX_BYTES - 1U) && (buf[i] > 0x0fU)) {
+				return 0U;
+			}
+			*v = val;
+			return i + 1U;
+		}
+	}
+
+	return 0U;
+}
+
+/** 64-bit variant of pcodec_varint_put(), for host side timestamps. */
+static inline size_t pcodec_varint_put64(uint8_t *buf, uint64_t v)
+{
+	size_t len = 0U;
+
+	while (v >= 0x80U) {
+		buf[len++] = (uint8_t)v | 0x80U;
+		v >>= 7;
+	}
+	buf[len++] = (uint8_t)v;
+
+	return len;
+}
+
+/** 64-bit variant of pcodec_varint_get(). */
+static inline size_t pcodec_varint_get64(const uint8_t *buf, size_t len,
+					 uint64_t *v)
+{
+	uint64_t val = 0U;
+
+	for (size_t i = 0U; (i < len) && (i < PCODEC_MAX_BYTES64); i++) {
+		val |= (uint64_t)(buf[i] & 0x7fU) << (7U * i);
+		if ((buf[i] & 0x80U) == 0U) {
+			if ((i == PCODEC_MAX_BYTES64 - 1U) && (buf[i] > 0x01U)) {
+				return 0U;
+			}
+			*v = val;
+			return i + 1U;
+		}
+	}
+
+	return 0U;
+}
+
+/** Bytes pcodec_encode() would write for @p period. */
+static inline size_t pcodec_encoded_len(const struct pcodec_state *st,
+					uint32_t period)
+{
+	return pcodec_varint_len(pcodec_zigzag((int32_t)(period - st->prev)));
+}
+
+/**
+ * Code one period of a stream.
+ *
+ * @param buf Output, at least PCODEC_MAX_BYTES long.
+ *
+ * @return Bytes written.
+ */
+static inline size_t pcodec_encode(struct pcodec_state *st, uint8_t *buf,
+				   uint32_t period)
+{
+	size_t len = pcodec_varint_put(buf, pcodec_zigzag(
+					       (int32_t)(period - st->prev)));
+
+	st->prev = period;
+
+	return len;
+}
+
+/**
+ * Decode one period of a stream.
+ *
+ * @return Bytes read, 0 if @p buf is truncated or malformed.
+ */
+static inline size_t pcodec_decode(struct pcodec_state *st, const uint8_t *buf,
+				   size_t len, uint32_t *period)
+{
+	uint32_t zz;
+	size_t n = pcodec_varint_get(buf, len, &zz);
+
+	if (n != 0U) {
+		st->prev += (uint32_t)pcodec_unzigzag(zz);
+		*period = st->prev;
+	}
+
+	return n;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERIOD_CODEC_H_ */
@@ -47,6 +47,7 @@ extern "C" {
 #define IC_CAPTURE_TYPE_MASK		(3U << IC_CAPTURE_TYPE_SHIFT)
 #define IC_CAPTURE_MODE_SHIFT		3U
 #define IC_CAPTURE_MODE_MASK		(1U << IC_CAPTURE_MODE_SHIFT)
+#define IC_CAPTURE_DUTY_SHIFT		4U
 /** @endcond */
 
 /** IC pin capture captures period. */
@@ -65,6 +66,18 @@ extern "C" {
 /** IC pin capture captures period/pulse width continuously. */
 #define IC_CAPTURE_MODE_CONTINUOUS	(1U << IC_CAPTURE_MODE_SHIFT)
 
+/**
+ * Continuous capture sampling bursts of edges while the period is steady.
+ *
+ * Only supported in free-running mode, when the driver is built with
+ * duty-cycled capture. Between bursts no edge is reported and the capture
+ * interrupt is off; each burst starts with a reference edge. A change in the
+ * period keeps every edge reported until it settles, so an input change is
+ * seen at most one idle interval plus two periods late: the reference edge
+ * and the first measured period of the next burst.
+ */
+#define IC_CAPTURE_DUTY_CYCLED		(1U << IC_CAPTURE_DUTY_SHIFT)
+
 /** @} */
 
 /**
@@ -428,6 +441,33 @@ typedef int (*ic_enable_capture_t)(const struct device *dev, uint32_t channel);
 typedef int (*ic_disable_capture_t)(const struct device *dev,
 				     uint32_t channel);
 
+/**
+ * @brief IC driver API call to get the time elapsed since the last edge.
+ * @see ic_get_capture_age() for argument description
+ */
+typedef int (*ic_get_capture_age_t)(const struct device *dev,
+				     uint32_t channel, uint32_t *cycles);
+
+/**
+ * @brief IC driver API call to route an input to an output in hardware.
+ * @see ic_set_passthrough() for argument description
+ */
+typedef int (*ic_set_passthrough_t)(const struct device *dev,
+				     uint32_t in_channel, uint32_t out_channel,
+				     uint32_t pulse_cycles);
+
+/**
+ * @brief IC driver API call to reload the timer clock rate.
+ * @see ic_clock_changed() for argument description
+ */
+typedef int (*ic_clock_changed_t)(const struct device *dev);
+
+/**
+ * @brief IC driver API call to correct the timer clock rate.
+ * @see ic_set_calibration() for argument description
+ */
+typedef int (*ic_set_calibration_t)(const struct device *dev, int32_t ppm);
+
 /** @brief IC driver API definition. */
 __subsystem struct ic_driver_api {
 	ic_get_cycles_per_sec_t get_cycles_per_sec;
@@ -435,9 +475,89 @@ __subsystem struct ic_driver_api {
 	ic_configure_capture_t configure_capture;
 	ic_enable_capture_t enable_capture;
 	ic_disable_capture_t disable_capture;
+
+	ic_set_cycles_t set_cycles;
+
+	ic_get_capture_age_t get_capture_age;
+	ic_set_passthrough_t set_passthrough;
+	ic_clock_changed_t clock_changed;
+	ic_set_calibration_t set_calibration;
 };
+
+/*
+ * Single instance builds: when the STM32 driver is the only IC driver and it
+ * has exactly one enabled instance, calls are resolved statically to the
+ * driver functions instead of going through struct ic_driver_api.
+ */
+#if defined(CONFIG_IC_STM32_DIRECT_CALLS) &&				       \
+	DT_HAS_COMPAT_STATUS_OKAY(st_stm32_ic) &&			       \
+	(DT_NUM_INST_STATUS_OKAY(st_stm32_ic) == 1)
+#define IC_DIRECT_CALLS 1
+
+int ic_stm32_get_cycles_per_sec(const struct device *dev, uint32_t channel,
+				uint64_t *cycles);
+int ic_stm32_configure_capture(const struct device *dev, uint32_t channel,
+			       ic_flags_t flags,
+			       ic_capture_callback_handler_t cb,
+			       void *user_data);
+int ic_stm32_enable_capture(const struct device *dev, uint32_t channel);
+int ic_stm32_disable_capture(const struct device *dev, uint32_t channel);
+int ic_stm32_set_cycles(const struct device *dev, uint32_t channel,
+			uint32_t period_cycles, uint32_t pulse_cycles,
+			ic_flags_t flags);
+int ic_stm32_get_capture_age(const struct device *dev, uint32_t channel,
+			     uint32_t *cycles);
+int ic_stm32_set_passthrough(const struct device *dev, uint32_t in_channel,
+			     uint32_t out_channel, uint32_t pulse_cycles);
+int ic_stm32_clock_changed(const struct device *dev);
+int ic_stm32_set_calibration(const struct device *dev, int32_t ppm);
+#else
+#define IC_DIRECT_CALLS 0
+#endif
 /** @endcond */
 
+/**
+ * @brief Set the period and pulse width for a single IC output.
+ *
+ * The output is generated with output compare on a free-running counter, so
+ * it can share its timer with captures and other outputs. The new values are
+ * applied from the next output edge. A pulse of 0 or equal to the period
+ * holds the output at a constant level.
+ *
+ * @param[in] dev IC device instance.
+ * @param channel IC channel.
+ * @param period Period (in clock cycles).
+ * @param pulse Pulse width (in clock cycles).
+ * @param flags Flags for pin configuration.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If pulse > period or the channel is invalid.
+ * @retval -EBUSY If the channel is used for capture.
+ * @retval -ENOTSUP If the device is not in free-running mode.
+ * @retval -ENOSYS If outputs are not supported.
+ * @retval -errno Negative errno code on failure.
+ */
+__syscall int ic_set_cycles(const struct device *dev, uint32_t channel,
+			     uint32_t period, uint32_t pulse, ic_flags_t flags);
+
+static inline int z_impl_ic_set_cycles(const struct device *dev,
+					uint32_t channel, uint32_t period,
+					uint32_t pulse, ic_flags_t flags)
+{
+#if IC_DIRECT_CALLS
+	return ic_stm32_set_cycles(dev, channel, period, pulse, flags);
+#else
+	const struct ic_driver_api *api =
+		(const struct ic_driver_api *)dev->api;
+
+	if (api->set_cycles == NULL) {
+		return -ENOSYS;
+	}
+
+	return api->set_cycles(dev, channel, period, pulse, flags);
+#endif
+}
+
 /**
  * @brief Get the clock rate (cycles per second) for a single IC output.
  *
@@ -456,10 +576,14 @@ static inline int z_impl_ic_get_cycles_per_sec(const struct device *dev,
 						uint32_t channel,
 						uint64_t *cycles)
 {
+#if IC_DIRECT_CALLS
+	return ic_stm32_get_cycles_per_sec(dev, channel, cycles);
+#else
 	const struct ic_driver_api *api =
 		(const struct ic_driver_api *)dev->api;
 
 	return api->get_cycles_per_sec(dev, channel, cycles);
+#endif
 }
 
 /**
@@ -559,6 +683,9 @@ static inline int ic_configure_capture(const struct device *dev,
 					ic_capture_callback_handler_t cb,
 					void *user_data)
 {
+#if IC_DIRECT_CALLS
+	return ic_stm32_configure_capture(dev, channel, flags, cb, user_data);
+#else
 	const struct ic_driver_api *api =
 		(const struct ic_driver_api *)dev->api;
 
@@ -568,6 +695,7 @@ static inline int ic_configure_capture(const struct device *dev,
 
 	return api->configure_capture(dev, channel, flags, cb,
 					      user_data);
+#endif
 }
 
 /**
@@ -591,6 +719,9 @@ __syscall int ic_enable_capture(const struct device *dev, uint32_t channel);
 static inline int z_impl_ic_enable_capture(const struct device *dev,
 					    uint32_t channel)
 {
+#if IC_DIRECT_CALLS
+	return ic_stm32_enable_capture(dev, channel);
+#else
 	const struct ic_driver_api *api =
 		(const struct ic_driver_api *)dev->api;
 
@@ -599,6 +730,7 @@ static inline int z_impl_ic_enable_capture(const struct device *dev,
 	}
 
 	return api->enable_capture(dev, channel);
+#endif
 }
 
 /**
@@ -617,6 +749,9 @@ __syscall int ic_disable_capture(const struct device *dev, uint32_t channel);
 static inline int z_impl_ic_disable_capture(const struct device *dev,
 					     uint32_t channel)
 {
+#if IC_DIRECT_CALLS
+	return ic_stm32_disable_capture(dev, channel);
+#else
 	const struct ic_driver_api *api =
 		(const struct ic_driver_api *)dev->api;
 
@@ -625,6 +760,152 @@ static inline int z_impl_ic_disable_capture(const struct device *dev,
 	}
 
 	return api->disable_capture(dev, channel);
+#endif
+}
+
+/**
+ * @brief Get the time elapsed since the last edge captured on an input.
+ *
+ * Meant to be called from the capture callback, to measure how late the
+ * processing of an edge is. The result wraps after one counter period.
+ *
+ * @param[in] dev IC device instance.
+ * @param channel IC channel, with an active capture.
+ * @param[out] cycles Cycles elapsed since the last captured edge.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If the channel has no active capture.
+ * @retval -ENOSYS If not supported by the driver.
+ */
+__syscall int ic_get_capture_age(const struct device *dev, uint32_t channel,
+				  uint32_t *cycles);
+
+static inline int z_impl_ic_get_capture_age(const struct device *dev,
+					     uint32_t channel, uint32_t *cycles)
+{
+#if IC_DIRECT_CALLS
+	return ic_stm32_get_capture_age(dev, channel, cycles);
+#else
+	const struct ic_driver_api *api =
+		(const struct ic_driver_api *)dev->api;
+
+	if (api->get_capture_age == NULL) {
+		return -ENOSYS;
+	}
+
+	return api->get_capture_age(dev, channel, cycles);
+#endif
+}
+
+/**
+ * @brief Drive an output from an input edge by edge, without the CPU.
+ *
+ * Each edge captured on @p in_channel starts a pulse of @p pulse_cycles on
+ * @p out_channel, so the output follows the input frequency unscaled. The
+ * capture keeps reporting periods meanwhile. Other captures and outputs of
+ * the device must be stopped. A @p pulse_cycles of 0 ends the pass-through
+ * and forces @p out_channel inactive until the next ic_set_cycles().
+ *
+ * @param[in] dev IC device instance.
+ * @param in_channel Input channel, with an active capture.
+ * @param out_channel Output channel.
+ * @param pulse_cycles Output pulse width (in clock cycles), 0 to stop.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If a channel is invalid.
+ * @retval -EBUSY If other channels of the device are in use.
+ * @retval -ENOTSUP If the timer or input channel cannot trigger a reset.
+ * @retval -ENOSYS If not supported by the driver.
+ */
+__syscall int ic_set_passthrough(const struct device *dev, uint32_t in_channel,
+				  uint32_t out_channel, uint32_t pulse_cycles);
+
+static inline int z_impl_ic_set_passthrough(const struct device *dev,
+					     uint32_t in_channel,
+					     uint32_t out_channel,
+					     uint32_t pulse_cycles)
+{
+#if IC_DIRECT_CALLS
+	return ic_stm32_set_passthrough(dev, in_channel, out_channel,
+					pulse_cycles);
+#else
+	const struct ic_driver_api *api =
+		(const struct ic_driver_api *)dev->api;
+
+	if (api->set_passthrough == NULL) {
+		return -ENOSYS;
+	}
+
+	return api->set_passthrough(dev, in_channel, out_channel,
+				    pulse_cycles);
+#endif
+}
+
+/**
+ * @brief Reload the timer clock rate after a clock tree change.
+ *
+ * The driver caches its counter clock rate. Whoever changes the system or
+ * bus clocks at runtime must call this once the new rate is applied, so
+ * that ic_get_cycles_per_sec() and the conversions follow. Running outputs
+ * are rescaled to keep their timings; each capture drops the period that
+ * spans the change instead of reporting it in mixed clocks.
+ *
+ * @param[in] dev IC device instance.
+ *
+ * @retval 0 If successful.
+ * @retval -ENOSYS If not supported by the driver.
+ * @retval -errno Other negative errno code on failure.
+ */
+__syscall int ic_clock_changed(const struct device *dev);
+
+static inline int z_impl_ic_clock_changed(const struct device *dev)
+{
+#if IC_DIRECT_CALLS
+	return ic_stm32_clock_changed(dev);
+#else
+	const struct ic_driver_api *api =
+		(const struct ic_driver_api *)dev->api;
+
+	if (api->clock_changed == NULL) {
+		return -ENOSYS;
+	}
+
+	return api->clock_changed(dev);
+#endif
+}
+
+/**
+ * @brief Correct the timer clock rate by a measured error.
+ *
+ * The rate returned by ic_get_cycles_per_sec(), and so every conversion,
+ * becomes the nominal rate times (1 + @p ppm / 1e6). The correction is
+ * applied once, to the cached rate, and costs nothing per conversion. It
+ * is kept across ic_clock_changed().
+ *
+ * @param[in] dev IC device instance.
+ * @param ppm Timer clock error (ppm), positive when the clock runs fast.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If the correction is out of range.
+ * @retval -ENOSYS If not supported by the driver.
+ */
+__syscall int ic_set_calibration(const struct device *dev, int32_t ppm);
+
+static inline int z_impl_ic_set_calibration(const struct device *dev,
+					     int32_t ppm)
+{
+#if IC_DIRECT_CALLS
+	return ic_stm32_set_calibration(dev, ppm);
+#else
+	const struct ic_driver_api *api =
+		(const struct ic_driver_api *)dev->api;
+
+	if (api->set_calibration == NULL) {
+		return -ENOSYS;
+	}
+
+	return api->set_calibration(dev, ppm);
+#endif
 }
 
 /**
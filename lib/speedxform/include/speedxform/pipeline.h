@@ -0,0 +1,149 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * Capture to output pipeline: what the firmware does with each captured
+ * input period, over integer timer cycles only.
+ *
+ * The input period goes through the transform of xform.h, the input pulse
+ * is scaled by the same ratio and clamped to the output period, and both
+ * are converted from the input timer clock to the output timer clock. The
+ * firmware calls it from the capture callback; host tools and benchmarks
+ * compile the same code.
+ *
+ * The transform parameters can change while edges are processed. They are
+ * double buffered: sx_pipeline_set_params() fills the copy not in use and
+ * then publishes it with a single pointer store, and each step reads the
+ * parameters through a single pointer load. A step thus sees either the
+ * old or the new parameters as a whole, without any lock on the hot path,
+ * and updates take effect at the next edge.
+ *
+ * Further outputs can be fed from the same capture with sx_pipeline_tap():
+ * they share the filtering of the step but have their own speed ratio
+ * and output clock.
+ */
+
+#ifndef SPEEDXFORM_PIPELINE_H_
+#define SPEEDXFORM_PIPELINE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <speedxform/xform.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Pipeline state, set up by sx_pipeline_init(). */
+struct sx_pipeline {
+	/** Parameters in use, one of params_buf. */
+	const struct xform_params *params;
+	struct xform_params params_buf[2];
+	struct xform_state state;
+	/** Input (capture) timer clock (Hz). */
+	uint32_t in_hz;
+	/** Output timer clock (Hz). */
+	uint32_t out_hz;
+};
+
+/** Result of one pipeline step. */
+struct sx_output {
+	/** Transformed period, in input timer cycles. */
+	uint32_t xform_cycles;
+	/** Output period, in output timer cycles, 0 to stop the output. */
+	uint32_t period;
+	/** Output pulse width, in output timer cycles. */
+	uint32_t pulse;
+	/** Speed ratio applied. */
+	uint32_t ratio_num;
+	uint32_t ratio_den;
+};
+
+/** Further output fed from a pipeline, see sx_pipeline_tap(). */
+struct sx_tap {
+	/** Output period = input period * ratio_num / ratio_den. */
+	uint32_t ratio_num;
+	uint32_t ratio_den;
+	/** Output timer clock (Hz). */
+	uint32_t out_hz;
+};
+
+/**
+ * Set up a pipeline.
+ *
+ * @param p Pipeline.
+ * @param params Transform parameters, copied.
+ * @param in_hz Input timer clock (Hz).
+ * @param out_hz Output timer clock (Hz).
+ */
+void sx_pipeline_init(struct sx_pipeline *p, const struct xform_params *params,
+		      uint32_t in_hz, uint32_t out_hz);
+
+/**
+ * Change the transform parameters.
+ *
+ * Writers must be serialized by the caller. The copy filled here is the
+ * one the previous update replaced, so no step may still be running on it:
+ * this holds when steps run from an interrupt on the writer's CPU, which
+ * completes before the writer resumes. The transform state is kept.
+ *
+ * @param p Pipeline.
+ * @param params New parameters, copied.
+ *
+ * @return false if the parameters are invalid: a ratio term of 0, a window
+ *         outside 1 to XFORM_WINDOW_MAX or a hysteresis over
+ *         XFORM_HYSTERESIS_MAX_PPM. They are then ignored.
+ */
+bool sx_pipeline_set_params(struct sx_pipeline *p,
+			    const struct xform_params *params);
+
+/**
+ * Current transform parameters.
+ *
+ * @param p Pipeline.
+ * @param[out] params Parameters.
+ */
+void sx_pipeline_get_params(const struct sx_pipeline *p,
+			    struct xform_params *params);
+
+/**
+ * Feed one captured input period.
+ *
+ * @param p Pipeline.
+ * @param period Input period (input cycles), 0 when the input stopped.
+ * @param pulse Input pulse width (input cycles).
+ * @param out Output timings.
+ *
+ * @return false if the output timings do not fit 32 bits; out then stops
+ *         the output.
+ */
+bool sx_pipeline_step(struct sx_pipeline *p, uint32_t period, uint32_t pulse,
+		      struct sx_output *out);
+
+/**
+ * Derive the timings of a further output from a step.
+ *
+ * The filtered period of the step is scaled by the ratio of the tap
+ * instead of the pipeline ratio, and converted to the tap clock.
+ *
+ * @param p Pipeline.
+ * @param main Result of sx_pipeline_step().
+ * @param pulse Input pulse width given to that step (input cycles).
+ * @param tap Further output, ratio_den not 0.
+ * @param out Output timings.
+ *
+ * @return false if the output timings do not fit 32 bits; out then stops
+ *         the output.
+ */
+bool sx_pipeline_tap(const struct sx_pipeline *p, const struct sx_output *main,
+		     uint32_t pulse, const struct sx_tap *tap,
+		     struct sx_output *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPEEDXFORM_PIPELINE_H_ */
@@ -0,0 +1,146 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * Streaming quantiles of a ratio, in constant memory and without division
+ * per sample, free of any Zephyr dependency like xform.h.
+ *
+ * Samples are counted in fixed logarithmic bins, eight per octave, from
+ * 2^-QHIST_OCTAVES (2^-20, about 1 ppm, by default) up to 2^3. The bin of
+ * num/den is the difference of the integer logarithms of num and den: a
+ * count leading zeros, a shift and a table lookup each. Truncating both
+ * logarithms puts a ratio at most one bin (9 %) away from its own, but the
+ * two truncations cancel out on average: bin k holds ratios centered on
+ * 2^(k/8), not ratios from 2^(k/8) up, so quantiles are read back as
+ * 2^(k/8).
+ */
+
+#ifndef SPEEDXFORM_QUANTILE_H_
+#define SPEEDXFORM_QUANTILE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+/** Bins per octave, as log2. */
+#define QHIST_SUB_BITS 3U
+
+/** Mantissa bits looked up to get the fractional logarithm. */
+#define QHIST_MANT_BITS 5U
+
+#ifdef CONFIG_SPEEDXFORM_QHIST_OCTAVES
+#define QHIST_OCTAVES CONFIG_SPEEDXFORM_QHIST_OCTAVES
+#else
+/** Octaves below a ratio of 1 covered by the bins. */
+#define QHIST_OCTAVES 20U
+#endif
+
+/** Bin of a ratio of 1. */
+#define QHIST_UNITY (QHIST_OCTAVES << QHIST_SUB_BITS)
+
+#define QHIST_BINS (QHIST_UNITY + (3U << QHIST_SUB_BITS))
+
+/** Fixed-bin histogram, zero initialized. */
+struct qhist {
+	uint32_t count[QHIST_BINS];
+	uint32_t total;
+};
+
+static inline void qhist_reset(struct qhist *h)
+{
+	memset(h, 0, sizeof(*h));
+}
+
+/** log2(x) with QHIST_SUB_BITS fractional bits, truncated. x > 0. */
+static inline uint32_t qhist_log2(uint32_t x)
+{
+	/* floor(8 * log2(1 + m / 32)) */
+	static const uint8_t frac[1U << QHIST_MANT_BITS] = {
+		0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 3, 3, 3, 3, 4, 4,
+		4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 6, 7, 7, 7, 7, 7,
+	};
+	uint32_t msb = 31U - (uint32_t)__builtin_clz(x);
+	uint32_t mant = (msb >= QHIST_MANT_BITS) ? x >> (msb - QHIST_MANT_BITS) :
+						   x << (QHIST_MANT_BITS - msb);
+
+	return (msb << QHIST_SUB_BITS) |
+	       frac[mant & ((1U << QHIST_MANT_BITS) - 1U)];
+}
+
+/**
+ * Count the ratio num / den. A num of 0 or a ratio below the first bin
+ * lands in the first bin, a ratio beyond the last bin in the last one.
+ */
+static inline void qhist_add(struct qhist *h, uint32_t num, uint32_t den)
+{
+	int32_t bin = 0;
+
+	if ((num != 0U) && (den != 0U)) {
+		bin = (int32_t)qhist_log2(num) - (int32_t)qhist_log2(den) +
+		      (int32_t)QHIST_UNITY;
+		if (bin < 0) {
+			bin = 0;
+		} else if (bin >= (int32_t)QHIST_BINS) {
+			bin = QHIST_BINS - 1U;
+		}
+	}
+
+	if (h->total == UINT32_MAX) {
+		/* keep the shape, forget half of the history */
+		h->total = 0U;
+		for (uint32_t i = 0U; i < QHIST_BINS; i++) {
+			h->count[i] >>= 1;
+			h->total += h->count[i];
+		}
+	}
+
+	h->count[bin]++;
+	h->total++;
+}
+
+/**
+ * Get a quantile of the counted ratios.
+ *
+ * @param h Histogram.
+ * @param permille Quantile, 0 to 1000.
+ *
+ * @return Nominal ratio 2^(bin/8) of the bin holding the quantile, in ppm;
+ *         0 if nothing was counted or the quantile is in the first bin.
+ */
+static inline uint32_t qhist_quantile_ppm(const struct qhist *h,
+					  uint32_t permille)
+{
+	/* 2^(k/8) * 1e6 */
+	static const uint32_t sub_ppm[1U << QHIST_SUB_BITS] = {
+		1000000U, 1090508U, 1189207U, 1296840U,
+		1414214U, 1542211U, 1681793U, 1834008U,
+	};
+	uint64_t rank = ((uint64_t)h->total * permille + 999U) / 1000U;
+	uint64_t seen = 0U;
+	uint32_t bin;
+	int32_t d;
+
+	for (bin = 0U; bin < QHIST_BINS - 1U; bin++) {
+		seen += h->count[bin];
+		if ((seen >= rank) && (seen != 0U)) {
+			break;
+		}
+	}
+
+	if (bin == 0U) {
+		return 0U;
+	}
+
+	/* log2 of the ratio is d / 8, split in octave and eighths */
+	d = (int32_t)bin - (int32_t)QHIST_UNITY;
+	if (d >= 0) {
+		uint64_t ppm = (uint64_t)sub_ppm[d & 7] << (d >> 3);
+
+		return (ppm > UINT32_MAX) ? UINT32_MAX : (uint32_t)ppm;
+	}
+
+	return sub_ppm[d & 7] >> ((-d + 7) >> 3);
+}
+
+#endif /* SPEEDXFORM_QUANTILE_H_ */
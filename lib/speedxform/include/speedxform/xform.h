@@ -0,0 +1,183 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * Speed signal transform, free of any Zephyr or hardware dependency so that
+ * host tools can replay recorded edges through the exact firmware code.
+ *
+ * Periods are in capture timer cycles. Each input period goes through a
+ * moving average, a linear predictor and a hysteresis band before being
+ * scaled by the speed ratio. The moving average spans either a fixed number
+ * of periods or, with a time window, the periods of the last window_cycles.
+ * The default parameters reduce to a plain ratio, which is what the
+ * firmware has always done.
+ */
+
+#ifndef SPEEDXFORM_XFORM_H_
+#define SPEEDXFORM_XFORM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Buffer sizes, from Kconfig in Zephyr builds: each xform_state holds
+ * XFORM_HIST_MAX periods.
+ */
+#ifdef CONFIG_SPEEDXFORM_WINDOW_MAX
+#define XFORM_WINDOW_MAX CONFIG_SPEEDXFORM_WINDOW_MAX
+#else
+/** Longest moving average window. */
+#define XFORM_WINDOW_MAX 16U
+#endif
+
+#ifdef CONFIG_SPEEDXFORM_HIST_MAX
+#define XFORM_HIST_MAX CONFIG_SPEEDXFORM_HIST_MAX
+#else
+/** Periods kept for the moving average, a power of two. */
+#define XFORM_HIST_MAX 32U
+#endif
+
+#if (XFORM_HIST_MAX & (XFORM_HIST_MAX - 1U)) != 0U
+#error "XFORM_HIST_MAX must be a power of two"
+#endif
+
+#if XFORM_WINDOW_MAX > XFORM_HIST_MAX
+#error "XFORM_WINDOW_MAX must not exceed XFORM_HIST_MAX"
+#endif
+
+/** Fixed point scale of the predictor gain. */
+#define XFORM_GAIN_ONE 256
+
+/** Widest hysteresis band (ppm): 10 % of the output period. */
+#define XFORM_HYSTERESIS_MAX_PPM 100000U
+
+/** Transform parameters. */
+struct xform_params {
+	/** Output period = input period * ratio_num / ratio_den, both > 0. */
+	uint32_t ratio_num;
+	uint32_t ratio_den;
+	/** Moving average length, 1 to XFORM_WINDOW_MAX. */
+	uint32_t window;
+	/**
+	 * Moving average time span (cycles), 0 to use window instead.
+	 * Averages the fewest recent periods covering it, at most
+	 * XFORM_HIST_MAX: the smoothing and its lag stay about constant in
+	 * time whatever the speed.
+	 */
+	uint32_t window_cycles;
+	/**
+	 * Output changes smaller than this are ignored (ppm), at most
+	 * XFORM_HYSTERESIS_MAX_PPM.
+	 */
+	uint32_t hysteresis_ppm;
+	/**
+	 * Extrapolation of the averaged period trend, in 1/XFORM_GAIN_ONE.
+	 * 0 disables the predictor.
+	 */
+	int32_t gain;
+};
+
+/** Default parameters: divide the speed by 2. */
+#define XFORM_PARAMS_DEFAULT			\
+	{					\
+		.ratio_num = 2U,		\
+		.ratio_den = 1U,		\
+		.window = 1U,			\
+		.window_cycles = 0U,		\
+		.hysteresis_ppm = 0U,		\
+		.gain = 0,			\
+	}
+
+/** Transform state, zero initialized. */
+struct xform_state {
+	/** Ring of the averaged periods, newest before idx. */
+	uint32_t hist[XFORM_HIST_MAX];
+	uint64_t sum;
+	uint32_t count;
+	uint32_t idx;
+	uint32_t last_avg;
+	uint32_t last_out;
+};
+
+static inline void xform_reset(struct xform_state *st)
+{
+	memset(st, 0, sizeof(*st));
+}
+
+/**
+ * Feed one input period.
+ *
+ * @param p Parameters.
+ * @param st State.
+ * @param period Input period (cycles), 0 when the input stopped.
+ *
+ * @return Output period (cycles), 0 to stop the output.
+ */
+static inline uint32_t xform_step(const struct xform_params *p,
+				  struct xform_state *st, uint32_t period)
+{
+	uint32_t window = (p->window_cycles != 0U) ? XFORM_HIST_MAX :
+			  (p->window == 0U) ? 1U :
+			  (p->window > XFORM_WINDOW_MAX) ? XFORM_WINDOW_MAX :
+			  p->window;
+	int64_t pred;
+	uint64_t out;
+	uint32_t avg;
+
+	if (period == 0U) {
+		xform_reset(st);
+		return 0U;
+	}
+
+	while (st->count >= window) {
+		st->sum -= st->hist[(st->idx - st->count) % XFORM_HIST_MAX];
+		st->count--;
+	}
+	st->hist[st->idx] = period;
+	st->sum += period;
+	st->count++;
+	st->idx = (st->idx + 1U) % XFORM_HIST_MAX;
+
+	/* periods are back to back: their sum is the time they span */
+	while ((p->window_cycles != 0U) && (st->count > 1U)) {
+		uint32_t oldest = st->hist[(st->idx - st->count) % XFORM_HIST_MAX];
+
+		if (st->sum - oldest < p->window_cycles) {
+			break;
+		}
+		st->sum -= oldest;
+		st->count--;
+	}
+	avg = (uint32_t)(st->sum / st->count);
+
+	pred = avg;
+	if ((p->gain != 0) && (st->last_avg != 0U)) {
+		pred += ((int64_t)avg - st->last_avg) * p->gain / XFORM_GAIN_ONE;
+		if (pred < 1) {
+			pred = 1;
+		}
+	}
+	st->last_avg = avg;
+
+	out = (uint64_t)pred * p->ratio_num / p->ratio_den;
+	if (out > UINT32_MAX) {
+		out = UINT32_MAX;
+	}
+
+	if ((p->hysteresis_ppm != 0U) && (st->last_out != 0U)) {
+		uint64_t diff = (out > st->last_out) ? out - st->last_out :
+			        st->last_out - out;
+
+		if (diff * 1000000U < (uint64_t)p->hysteresis_ppm * st->last_out) {
+			return st->last_out;
+		}
+	}
+	st->last_out = (uint32_t)out;
+
+	return st->last_out;
+}
+
+#endif /* SPEEDXFORM_XFORM_H_ */
@@ -0,0 +1,103 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <speedxform/pipeline.h>
+
+void sx_pipeline_init(struct sx_pipeline *p, const struct xform_params *params,
+		      uint32_t in_hz, uint32_t out_hz)
+{
+	p->params_buf[0] = *params;
+	p->params = &p->params_buf[0];
+	xform_reset(&p->state);
+	p->in_hz = in_hz;
+	p->out_hz = out_hz;
+}
+
+bool sx_pipeline_set_params(struct sx_pipeline *p,
+			    const struct xform_params *params)
+{
+	struct xform_params *next;
+
+	if ((params->ratio_num == 0U) || (params->ratio_den == 0U) ||
+	    (params->window == 0U) || (params->window > XFORM_WINDOW_MAX) ||
+	    (params->hysteresis_ppm > XFORM_HYSTERESIS_MAX_PPM)) {
+		return false;
+	}
+
+	next = (p->params == &p->params_buf[0]) ? &p->params_buf[1] :
+						  &p->params_buf[0];
+	*next = *params;
+	/* the copy above must be complete before a step can see it */
+	__atomic_store_n(&p->params, next, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+void sx_pipeline_get_params(const struct sx_pipeline *p,
+			    struct xform_params *params)
+{
+	*params = *__atomic_load_n(&p->params, __ATOMIC_ACQUIRE);
+}
+
+/* Convert input cycle timings to an output clock, the pulse clamped. */
+static bool sx_convert(const struct sx_pipeline *p, uint32_t out_hz,
+		       uint64_t period, uint64_t pulse, struct sx_output *out)
+{
+	uint64_t out_period, out_pulse;
+
+	if (pulse > period) {
+		pulse = period;
+	}
+
+	out_period = period * out_hz / p->in_hz;
+	out_pulse = pulse * out_hz / p->in_hz;
+	if ((period > UINT32_MAX) || (out_period > UINT32_MAX)) {
+		out->period = 0U;
+		out->pulse = 0U;
+		return false;
+	}
+
+	out->period = (uint32_t)out_period;
+	out->pulse = (uint32_t)out_pulse;
+
+	return true;
+}
+
+bool sx_pipeline_step(struct sx_pipeline *p, uint32_t period, uint32_t pulse,
+		      struct sx_output *out)
+{
+	const struct xform_params *params =
+		__atomic_load_n(&p->params, __ATOMIC_ACQUIRE);
+
+	out->xform_cycles = xform_step(params, &p->state, period);
+	out->ratio_num = params->ratio_num;
+	out->ratio_den = params->ratio_den;
+
+	return sx_convert(p, p->out_hz, out->xform_cycles,
+			  (uint64_t)pulse * params->ratio_num /
+			  params->ratio_den, out);
+}
+
+bool sx_pipeline_tap(const struct sx_pipeline *p, const struct sx_output *main,
+		     uint32_t pulse, const struct sx_tap *tap,
+		     struct sx_output *out)
+{
+	uint64_t period = 0U;
+
+	/* undo the ratio of the step, keeping its filtering */
+	if (main->ratio_num != 0U) {
+		period = (uint64_t)main->xform_cycles * main->ratio_den /
+			 main->ratio_num;
+		period = period * tap->ratio_num / tap->ratio_den;
+	}
+
+	out->xform_cycles = (period > UINT32_MAX) ? UINT32_MAX :
+							(uint32_t)period;
+	out->ratio_num = tap->ratio_num;
+	out->ratio_den = tap->ratio_den;
+
+	return sx_convert(p, tap->out_hz, period,
+			  (uint64_t)pulse * tap->ratio_num / tap->ratio_den,
+			  out);
+}
@@ -0,0 +1,442 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "compare.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "xcorr.hpp"
+
+namespace {
+
+/* Longest correlated series, bounds the FFT to 2^23 points. */
+constexpr size_t grid_max = 1U << 22;
+
+/* Fewest edges matched per task. */
+constexpr size_t min_chunk = 1U << 14;
+
+constexpr double no_value = std::numeric_limits<double>::quiet_NaN();
+
+double median_period(const std::vector<double> &edges)
+{
+	std::vector<double> p(edges.size() - 1);
+
+	for (size_t i = 0; i + 1 < edges.size(); i++) {
+		p[i] = edges[i + 1] - edges[i];
+	}
+	std::nth_element(p.begin(), p.begin() + p.size() / 2, p.end());
+
+	return p[p.size() / 2];
+}
+
+/*
+ * Speed (scale / period) sampled every h from the first edge on, linear
+ * between the middles of the periods: captures of different period
+ * lengths then line up without a bias of half a period.
+ */
+std::vector<double> speed_grid(const std::vector<double> &edges, double scale,
+			       double h)
+{
+	size_t n = static_cast<size_t>((edges.back() - edges.front()) / h);
+	std::vector<double> g(n);
+	size_t last = edges.size() - 2;
+	size_t i = 0;
+	auto mid = [&](size_t k) { return (edges[k] + edges[k + 1]) / 2.0; };
+	auto speed = [&](size_t k) { return scale / (edges[k + 1] - edges[k]); };
+
+	for (size_t k = 0; k < n; k++) {
+		double t = edges.front() + k * h;
+
+		while (i < last && mid(i + 1) <= t) {
+			i++;
+		}
+		if (t <= mid(i) || i == last) {
+			g[k] = speed(i);
+		} else {
+			double f = (t - mid(i)) / (mid(i + 1) - mid(i));
+
+			g[k] = speed(i) + f * (speed(i + 1) - speed(i));
+		}
+	}
+
+	return g;
+}
+
+/* Prefix sums of v and v^2, for the statistics of any overlap. */
+struct prefix {
+	std::vector<double> s, s2;
+
+	explicit prefix(const std::vector<double> &v)
+		: s(v.size() + 1), s2(v.size() + 1)
+	{
+		for (size_t i = 0; i < v.size(); i++) {
+			s[i + 1] = s[i] + v[i];
+			s2[i + 1] = s2[i] + v[i] * v[i];
+		}
+	}
+};
+
+/* Tolerance of a reference edge: half its shorter neighbouring period. */
+double tolerance(const std::vector<double> &ref, size_t i)
+{
+	double tol = std::numeric_limits<double>::infinity();
+
+	if (i > 0) {
+		tol = ref[i] - ref[i - 1];
+	}
+	if (i + 1 < ref.size()) {
+		tol = std::min(tol, ref[i + 1] - ref[i]);
+	}
+
+	return tol / 2.0;
+}
+
+struct chunk_result {
+	std::vector<edge_pair> edges;
+	size_t matched = 0;
+	size_t missing = 0;
+	size_t extra = 0;
+};
+
+/* Greedy nearest edge matching of ref[ia, ib) and cand[ja, jb). */
+void match(const std::vector<double> &ref, const std::vector<double> &cand,
+	   double offset, size_t ia, size_t ib, size_t ja, size_t jb,
+	   chunk_result &out)
+{
+	size_t j = ja;
+
+	for (size_t i = ia; i < ib; i++) {
+		double t = ref[i] + offset;
+		double tol = tolerance(ref, i);
+
+		while (j < jb && cand[j] < t - tol) {
+			out.edges.push_back({edge_pair::none, j++, no_value, no_value});
+			out.extra++;
+		}
+		/* of several candidates in range, the others are extra */
+		while (j + 1 < jb && cand[j + 1] <= t + tol &&
+		       std::fabs(cand[j + 1] - t) < std::fabs(cand[j] - t)) {
+			out.edges.push_back({edge_pair::none, j++, no_value, no_value});
+			out.extra++;
+		}
+		if (j < jb && cand[j] <= t + tol) {
+			out.edges.push_back({i, j, cand[j] - t, no_value});
+			out.matched++;
+			j++;
+		} else {
+			out.edges.push_back({i, edge_pair::none, no_value, no_value});
+			out.missing++;
+		}
+	}
+	for (; j < jb; j++) {
+		out.edges.push_back({edge_pair::none, j, no_value, no_value});
+		out.extra++;
+	}
+}
+
+/*
+ * Chunks of reference edges, each with the candidate edges up to half way
+ * to the next chunk, matched in parallel into res.
+ */
+void match_all(const std::vector<double> &ref, const std::vector<double> &cand,
+	       double off, size_t ia, size_t ib, size_t ja, size_t jb,
+	       work_stealing_pool &pool, comparison &res)
+{
+	size_t chunks = std::max<size_t>(1, std::min<size_t>(
+		4 * pool.size(), (ib - ia) / min_chunk));
+	std::vector<size_t> ri(chunks + 1), ci(chunks + 1);
+	std::vector<chunk_result> parts(chunks);
+
+	for (size_t k = 0; k <= chunks; k++) {
+		ri[k] = ia + (ib - ia) * k / chunks;
+		if (k == 0 || k == chunks) {
+			ci[k] = k == 0 ? ja : jb;
+			continue;
+		}
+
+		double mid = (ref[ri[k] - 1] + ref[ri[k]]) / 2.0 + off;
+
+		ci[k] = std::lower_bound(cand.begin() + ja, cand.begin() + jb,
+					 mid) - cand.begin();
+	}
+	for (size_t k = 0; k < chunks; k++) {
+		pool.submit([&, k] {
+			match(ref, cand, off, ri[k], ri[k + 1], ci[k],
+			      ci[k + 1], parts[k]);
+		});
+	}
+	pool.wait();
+
+	res.edges.clear();
+	res.matched = res.missing = res.extra = 0;
+	for (auto &p : parts) {
+		res.edges.insert(res.edges.end(), p.edges.begin(), p.edges.end());
+		res.matched += p.matched;
+		res.missing += p.missing;
+		res.extra += p.extra;
+	}
+}
+
+} /* namespace */
+
+alignment align(const std::vector<double> &ref, const std::vector<double> &cand,
+		const compare_options &opts, work_stealing_pool &pool)
+{
+	if (ref.size() < 3 || cand.size() < 3) {
+		throw std::runtime_error("fewer than 3 edges to align");
+	}
+
+	alignment a{};
+	double span = std::max(ref.back() - ref.front(),
+			       cand.back() - cand.front());
+
+	a.resolution = opts.resolution;
+	if (a.resolution <= 0.0) {
+		a.resolution = std::min(median_period(ref),
+					median_period(cand)) / 4.0;
+	}
+	a.resolution = std::max(a.resolution, span / grid_max);
+
+	std::vector<double> x, y;
+
+	pool.submit([&] { x = speed_grid(ref, 1.0, a.resolution); });
+	pool.submit([&] { y = speed_grid(cand, opts.ratio, a.resolution); });
+	pool.wait();
+
+	a.offset = cand.front() - ref.front();
+	if (x.empty() || y.empty()) {
+		return a;
+	}
+
+	/* centered, for the precision of the sums */
+	double mx = prefix(x).s.back() / x.size();
+	double my = prefix(y).s.back() / y.size();
+
+	for (auto &v : x) {
+		v -= mx;
+	}
+	for (auto &v : y) {
+		v -= my;
+	}
+
+	std::vector<double> c = xcorr(x, y, pool);
+	prefix px(x), py(y);
+	size_t n = c.size();
+	auto nx = static_cast<long>(x.size());
+	auto ny = static_cast<long>(y.size());
+	double min_len = std::max(2.0, opts.min_overlap * std::min(nx, ny));
+	/* Pearson correlation over the overlap, -inf out of range */
+	auto at = [&](long m) {
+		long first = std::max(0L, -m);
+		long last = std::min(nx, ny - m);
+		long len = last - first;
+
+		if (m <= -nx || m >= ny || len < min_len) {
+			return -std::numeric_limits<double>::infinity();
+		}
+
+		double sx = px.s[last] - px.s[first];
+		double sy = py.s[last + m] - py.s[first + m];
+		double vx = px.s2[last] - px.s2[first] - sx * sx / len;
+		double vy = py.s2[last + m] - py.s2[first + m] - sy * sy / len;
+		double cov = c[m >= 0 ? m : n + m] - sx * sy / len;
+
+		return vx > 0.0 && vy > 0.0 ? cov / std::sqrt(vx * vy) : 0.0;
+	};
+	long best = 0;
+	double peak = -std::numeric_limits<double>::infinity();
+
+	for (long m = -nx + 1; m < ny; m++) {
+		double v = at(m);
+
+		if (v > peak) {
+			peak = v;
+			best = m;
+		}
+	}
+	if (!std::isfinite(peak)) {
+		throw std::runtime_error("captures too short for --min-overlap");
+	}
+
+	/* parabola through the peak and its neighbours */
+	double frac = 0.0, l = at(best - 1), r = at(best + 1);
+
+	if (std::isfinite(l) && std::isfinite(r) && l - 2 * peak + r < 0.0) {
+		frac = 0.5 * (l - r) / (l - 2 * peak + r);
+	}
+
+	a.offset += (best + frac) * a.resolution;
+	a.correlation = peak;
+
+	return a;
+}
+
+comparison compare(const std::vector<double> &ref,
+		   const std::vector<double> &cand, const alignment &a,
+		   const compare_options &opts, work_stealing_pool &pool)
+{
+	comparison res{};
+	size_t ia, ib, ja, jb;
+
+	res.align = a;
+	res.matched_edges = opts.ratio == 1.0;
+
+	/*
+	 * The grid only resolves the offset to a fraction of its step: once
+	 * matched, the edges are matched again with the median lag removed.
+	 */
+	for (int pass = 0; pass < (res.matched_edges ? 2 : 1); pass++) {
+		double off = res.align.offset;
+
+		res.t0 = std::max(ref.front(), cand.front() - off);
+		res.t1 = std::min(ref.back(), cand.back() - off);
+		if (res.t1 <= res.t0) {
+			throw std::runtime_error("the aligned captures do not "
+						 "overlap");
+		}
+
+		ia = std::lower_bound(ref.begin(), ref.end(), res.t0) -
+		     ref.begin();
+		ib = std::upper_bound(ref.begin(), ref.end(), res.t1) -
+		     ref.begin();
+		ja = std::lower_bound(cand.begin(), cand.end(), res.t0 + off) -
+		     cand.begin();
+		jb = std::upper_bound(cand.begin(), cand.end(), res.t1 + off) -
+		     cand.begin();
+		res.ref_edges = ib - ia;
+		res.cand_edges = jb - ja;
+
+		if (!res.matched_edges) {
+			break;
+		}
+
+		match_all(ref, cand, off, ia, ib, ja, jb, pool, res);
+		if (pass == 0 && res.matched > 0) {
+			std::vector<double> lags;
+
+			for (const auto &e : res.edges) {
+				if (!std::isnan(e.lag)) {
+					lags.push_back(e.lag);
+				}
+			}
+			std::nth_element(lags.begin(),
+					 lags.begin() + lags.size() / 2,
+					 lags.end());
+			res.align.offset += lags[lags.size() / 2];
+		}
+	}
+
+	if (!res.matched_edges) {
+		double off = res.align.offset;
+
+		res.edges.resize(jb - ja);
+		parallel_for(pool, jb - ja, min_chunk, [&](size_t first,
+							   size_t last) {
+			for (size_t k = first; k < last; k++) {
+				size_t j = ja + k;
+				edge_pair &e = res.edges[k];
+
+				e = {edge_pair::none, j, no_value, no_value};
+				if (j == 0) {
+					continue;
+				}
+
+				double mid = (cand[j - 1] + cand[j]) / 2.0 - off;
+				size_t i = std::upper_bound(ref.begin(), ref.end(),
+							    mid) - ref.begin();
+
+				if (i > 0 && i < ref.size()) {
+					double expected = (ref[i] - ref[i - 1]) *
+							  opts.ratio;
+
+					e.period_error = (cand[j] - cand[j - 1]) /
+							 expected - 1.0;
+				}
+			}
+		});
+
+		return res;
+	}
+
+	/*
+	 * Jitter moves edges across the ends of the overlap, where they
+	 * would count as missing or extra.
+	 */
+	auto paired = [](const edge_pair &e) {
+		return e.ref != edge_pair::none && e.cand != edge_pair::none;
+	};
+	auto first = std::find_if(res.edges.begin(), res.edges.end(), paired);
+	auto last = std::find_if(res.edges.rbegin(), res.edges.rend(),
+				 paired).base();
+
+	if (first < last) {
+		for (auto it = res.edges.begin(); it != res.edges.end(); it++) {
+			if (it < first || it >= last) {
+				(it->ref == edge_pair::none ? res.extra :
+				 res.missing)--;
+			}
+		}
+		res.edges.erase(last, res.edges.end());
+		res.edges.erase(res.edges.begin(), first);
+	}
+
+	/* period errors between successive matched pairs */
+	const edge_pair *prev = nullptr;
+
+	for (auto &e : res.edges) {
+		if (e.ref == edge_pair::none || e.cand == edge_pair::none) {
+			prev = nullptr;
+			continue;
+		}
+		if (prev != nullptr && prev->ref + 1 == e.ref &&
+		    prev->cand + 1 == e.cand) {
+			e.period_error = (cand[e.cand] - cand[prev->cand]) /
+					 (ref[e.ref] - ref[prev->ref]) - 1.0;
+		}
+		prev = &e;
+	}
+
+	return res;
+}
+
+summary summarize(std::vector<double> v)
+{
+	summary s{};
+
+	v.erase(std::remove_if(v.begin(), v.end(),
+			       [](double x) { return std::isnan(x); }),
+		v.end());
+	s.n = v.size();
+	if (v.empty()) {
+		return s;
+	}
+
+	std::sort(v.begin(), v.end());
+
+	double sum = 0.0, sq = 0.0;
+
+	for (double x : v) {
+		sum += x;
+	}
+	s.mean = sum / v.size();
+	for (double x : v) {
+		sq += (x - s.mean) * (x - s.mean);
+	}
+	s.stddev = std::sqrt(sq / v.size());
+
+	auto q = [&](double p) {
+		return v[static_cast<size_t>(std::lround(p * (v.size() - 1)))];
+	};
+
+	s.min = v.front();
+	s.p1 = q(0.01);
+	s.p50 = q(0.5);
+	s.p99 = q(0.99);
+	s.max = v.back();
+
+	return s;
+}
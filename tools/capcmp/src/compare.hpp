@@ -0,0 +1,104 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CAPCMP_COMPARE_HPP_
+#define CAPCMP_COMPARE_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include "pool.hpp"
+
+struct compare_options {
+	/** Expected candidate period / reference period. */
+	double ratio = 1.0;
+	/** Grid step of the correlated speed series (s), 0 for automatic. */
+	double resolution = 0.0;
+	/** Shortest overlap considered, fraction of the shorter capture. */
+	double min_overlap = 0.5;
+};
+
+struct alignment {
+	/** Candidate time - reference time of the same event (s). */
+	double offset;
+	/** Normalized correlation at the offset, 1 for identical speeds. */
+	double correlation;
+	/** Grid step used (s). */
+	double resolution;
+};
+
+/** A reference edge and the candidate edge matched to it. */
+struct edge_pair {
+	static constexpr size_t none = static_cast<size_t>(-1);
+
+	/** Edge indexes, none for a missing or an extra edge. */
+	size_t ref;
+	size_t cand;
+	/** Candidate - aligned reference edge time (s), if both are set. */
+	double lag;
+	/** Relative period error of the period ending here, NaN if none. */
+	double period_error;
+};
+
+struct comparison {
+	alignment align;
+	/** Overlap of the captures, in reference time (s). */
+	double t0;
+	double t1;
+	size_t ref_edges;
+	size_t cand_edges;
+	/** Edge matching only runs for a ratio of 1. */
+	bool matched_edges;
+	size_t matched;
+	size_t missing;
+	size_t extra;
+	/** In time order, over the overlap. */
+	std::vector<edge_pair> edges;
+};
+
+/**
+ * Find the time offset between two captures of the same speed.
+ *
+ * Both speed series, 1 / period, are sampled on a common grid and the
+ * offset is the peak of their FFT cross-correlation, normalized by the
+ * overlap length and refined between grid steps.
+ *
+ * @param ref Rising edge times of the reference (s).
+ * @param cand Rising edge times of the candidate (s).
+ *
+ * @throws std::runtime_error if a capture is too short.
+ */
+alignment align(const std::vector<double> &ref, const std::vector<double> &cand,
+		const compare_options &opts, work_stealing_pool &pool);
+
+/**
+ * Compare the edges of two aligned captures over their overlap.
+ *
+ * With a ratio of 1, each reference edge is matched to the nearest
+ * candidate edge within half a period: unmatched edges are missing or
+ * extra and the period error is taken between matched pairs. Otherwise
+ * each candidate period is compared to the reference period at the same
+ * time, scaled by the ratio.
+ *
+ * @return The comparison, its alignment refined by the edge matching.
+ */
+comparison compare(const std::vector<double> &ref,
+		   const std::vector<double> &cand, const alignment &a,
+		   const compare_options &opts, work_stealing_pool &pool);
+
+/** Distribution of a series. */
+struct summary {
+	size_t n;
+	double mean;
+	double stddev;
+	double min;
+	double p1;
+	double p50;
+	double p99;
+	double max;
+};
+
+summary summarize(std::vector<double> v);
+
+#endif /* CAPCMP_COMPARE_HPP_ */
@@ -0,0 +1,253 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Compare two captures of a speed signal, such as an output recording and
+ * a reference, or the outputs of two firmware versions.
+ *
+ * The captures are aligned with the FFT cross-correlation of their speed
+ * series, whatever their start times, then compared edge by edge: lag,
+ * missing and extra edges, period error distribution.
+ *
+ *   capcmp [options] <reference>[@CHANNEL] <candidate>[@CHANNEL]
+ */
+
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "compare.hpp"
+#include "pool.hpp"
+#include "streams.hpp"
+
+namespace {
+
+struct input {
+	std::string path;
+	std::string channel;
+	std::vector<double> edges;
+};
+
+input parse_input(const std::string &arg)
+{
+	size_t at = arg.rfind('@');
+
+	if (at == std::string::npos) {
+		return {arg, "0", {}};
+	}
+
+	return {arg.substr(0, at), arg.substr(at + 1), {}};
+}
+
+void usage(const char *name)
+{
+	std::fprintf(stderr,
+		"usage: %s [options] <reference>[@CH] <candidate>[@CH]\n"
+		"inputs are Logic 2 CSV or binary exports, edge stores or\n"
+		"telemetry console logs; CH is a column or channel name or\n"
+		"index (default 0), in or out for telemetry\n"
+		"  --ratio NUM/DEN     candidate/reference period (default 1/1)\n"
+		"  --resolution S      correlation grid step (default: a\n"
+		"                      quarter of the median period)\n"
+		"  --min-overlap F     shortest overlap, fraction of the\n"
+		"                      shorter capture (default 0.5)\n"
+		"  --clock HZ          telemetry period clock, if the log has\n"
+		"                      no TLM cps= line\n"
+		"  --threads N         worker threads (default: all cores)\n"
+		"  --csv FILE          write every edge\n", name);
+}
+
+void print_summary(const char *what, const summary &s, double scale)
+{
+	std::printf("%-18s %9zu %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f "
+		    "%10.3f\n", what, s.n, s.mean * scale, s.stddev * scale,
+		    s.min * scale, s.p1 * scale, s.p50 * scale, s.p99 * scale,
+		    s.max * scale);
+}
+
+void write_csv(const std::string &path, const input &ref, const input &cand,
+	       const comparison &c)
+{
+	std::ofstream out(path);
+
+	out << "ref_index,cand_index,ref_time_s,cand_time_s,lag_us,"
+	       "period_error_pct\n";
+	out.precision(12);
+	for (const auto &e : c.edges) {
+		if (e.ref != edge_pair::none) {
+			out << e.ref;
+		}
+		out << ',';
+		if (e.cand != edge_pair::none) {
+			out << e.cand;
+		}
+		out << ',';
+		if (e.ref != edge_pair::none) {
+			out << ref.edges[e.ref];
+		}
+		out << ',';
+		if (e.cand != edge_pair::none) {
+			out << cand.edges[e.cand];
+		}
+		out << ',';
+		if (!std::isnan(e.lag)) {
+			out << e.lag * 1e6;
+		}
+		out << ',';
+		if (!std::isnan(e.period_error)) {
+			out << e.period_error * 100.0;
+		}
+		out << '\n';
+	}
+	if (!out) {
+		throw std::runtime_error(path + ": write error");
+	}
+}
+
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+	compare_options opts;
+	double clock_hz = 0.0;
+	unsigned threads = std::thread::hardware_concurrency();
+	std::string csv;
+	std::vector<input> inputs;
+
+	try {
+		for (int i = 1; i < argc; i++) {
+			std::string arg = argv[i];
+			auto next = [&]() -> std::string {
+				if (i + 1 >= argc) {
+					throw std::invalid_argument(arg + " needs a value");
+				}
+				return argv[++i];
+			};
+
+			if (arg == "--ratio") {
+				std::string v = next();
+				unsigned long num, den;
+
+				if (std::sscanf(v.c_str(), "%lu/%lu", &num,
+						&den) != 2 || num == 0 || den == 0) {
+					throw std::invalid_argument("bad ratio: " + v);
+				}
+				opts.ratio = static_cast<double>(num) / den;
+			} else if (arg == "--resolution") {
+				opts.resolution = std::stod(next());
+			} else if (arg == "--min-overlap") {
+				opts.min_overlap = std::stod(next());
+			} else if (arg == "--clock") {
+				clock_hz = std::stod(next());
+			} else if (arg == "--threads") {
+				threads = std::stoul(next());
+			} else if (arg == "--csv") {
+				csv = next();
+			} else if (arg == "-h" || arg == "--help") {
+				usage(argv[0]);
+				return 0;
+			} else if (arg.rfind("--", 0) == 0) {
+				throw std::invalid_argument("unknown option " + arg);
+			} else {
+				inputs.push_back(parse_input(arg));
+			}
+		}
+		if (inputs.size() != 2) {
+			usage(argv[0]);
+			return 2;
+		}
+		if (opts.min_overlap <= 0.0 || opts.min_overlap > 1.0) {
+			throw std::invalid_argument("--min-overlap out of range");
+		}
+	} catch (const std::exception &e) {
+		std::fprintf(stderr, "%s\n", e.what());
+		return 2;
+	}
+
+	work_stealing_pool pool(threads);
+	input &ref = inputs[0];
+	input &cand = inputs[1];
+	comparison c;
+
+	try {
+		/* the parsers are single threaded, read both at once */
+		std::exception_ptr error[2];
+
+		for (size_t k = 0; k < 2; k++) {
+			pool.submit([&, k] {
+				try {
+					inputs[k].edges = load_edges(inputs[k].path,
+								     inputs[k].channel,
+								     clock_hz);
+				} catch (...) {
+					error[k] = std::current_exception();
+				}
+			});
+		}
+		pool.wait();
+		for (const auto &e : error) {
+			if (e) {
+				std::rethrow_exception(e);
+			}
+		}
+		for (const auto *in : {&ref, &cand}) {
+			std::printf("%s@%s: %zu edges over %.3f s\n",
+				    in->path.c_str(), in->channel.c_str(),
+				    in->edges.size(), in->edges.empty() ? 0.0 :
+				    in->edges.back() - in->edges.front());
+		}
+
+		alignment a = align(ref.edges, cand.edges, opts, pool);
+
+		c = compare(ref.edges, cand.edges, a, opts, pool);
+	} catch (const std::exception &e) {
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+
+	std::printf("offset %+.6f s, correlation %.3f, resolution %.3f ms\n",
+		    c.align.offset, c.align.correlation,
+		    c.align.resolution * 1e3);
+	if (c.align.correlation < 0.5) {
+		std::printf("warning: weak correlation, the alignment is "
+			    "unreliable\n");
+	}
+	std::printf("overlap %.3f s: %zu reference, %zu candidate edges\n",
+		    c.t1 - c.t0, c.ref_edges, c.cand_edges);
+
+	std::vector<double> lags, errors;
+
+	for (const auto &e : c.edges) {
+		lags.push_back(e.lag);
+		errors.push_back(e.period_error);
+	}
+
+	if (c.matched_edges) {
+		std::printf("edges: %zu matched, %zu missing, %zu extra\n",
+			    c.matched, c.missing, c.extra);
+	}
+	std::printf("%-18s %9s %10s %10s %10s %10s %10s %10s %10s\n", "",
+		    "n", "mean", "stddev", "min", "p1", "p50", "p99", "max");
+	if (c.matched_edges) {
+		print_summary("lag (us)", summarize(lags), 1e6);
+	}
+	print_summary("period error (%)", summarize(errors), 100.0);
+
+	if (!csv.empty()) {
+		try {
+			write_csv(csv, ref, cand, c);
+		} catch (const std::exception &e) {
+			std::fprintf(stderr, "%s\n", e.what());
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,173 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "streams.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "edgestore.hpp"
+#include "period_codec_batch.hpp"
+#include "saleae_export.hpp"
+
+namespace {
+
+std::vector<double> store_edges(const std::string &path,
+				const std::string &channel)
+{
+	edgestore::reader store(path);
+	int ch = store.find(channel);
+
+	if (ch < 0) {
+		char *end;
+		unsigned long idx = std::strtoul(channel.c_str(), &end, 10);
+
+		if (*end != '\0' || idx >= store.channel_count()) {
+			throw std::runtime_error(path + ": no channel " + channel);
+		}
+		ch = static_cast<int>(idx);
+	}
+
+	std::vector<double> edges;
+	double tick = 1.0 / static_cast<double>(store.tick_hz());
+
+	for (const auto &e : store.edges(ch, 0, UINT64_MAX)) {
+		if (e.level) {
+			edges.push_back(static_cast<double>(e.time) * tick);
+		}
+	}
+
+	return edges;
+}
+
+bool parse_hex(const std::string &hex, std::vector<uint8_t> &out)
+{
+	if (hex.size() % 2 != 0) {
+		return false;
+	}
+	for (size_t i = 0; i < hex.size(); i += 2) {
+		char *end;
+		std::string byte = hex.substr(i, 2);
+
+		out.push_back(static_cast<uint8_t>(std::strtoul(byte.c_str(),
+								&end, 16)));
+		if (*end != '\0') {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* "TLM <seq> <dropped> <hex>" frames, see pcodec_decode telemetry */
+std::vector<double> telemetry_edges(const std::string &path,
+				    const std::string &channel,
+				    double clock_hz)
+{
+	std::ifstream in(path);
+	std::vector<double> edges{0.0};
+	uint64_t cycles = 0;
+	unsigned long lost = 0;
+	size_t pick;
+	std::string line;
+
+	if (channel == "in" || channel == "0") {
+		pick = 0;
+	} else if (channel == "out" || channel == "1") {
+		pick = 1;
+	} else {
+		throw std::runtime_error(path + ": telemetry channels are in "
+					 "and out");
+	}
+
+	while (std::getline(in, line)) {
+		size_t pos = line.find("TLM ");
+
+		if (pos == std::string::npos) {
+			continue;
+		}
+		if (line.compare(pos + 4, 4, "cps=") == 0) {
+			clock_hz = std::strtod(line.c_str() + pos + 8, nullptr);
+			continue;
+		}
+
+		std::istringstream ss(line.substr(pos + 4));
+		std::string seq, hex;
+		unsigned long dropped;
+		std::vector<uint8_t> payload;
+
+		if (!(ss >> seq >> dropped >> hex) || !parse_hex(hex, payload)) {
+			continue;
+		}
+
+		std::vector<int32_t> deltas(payload.size());
+		size_t consumed;
+		size_t n = pcodec_decode_deltas(payload.data(), payload.size(),
+						deltas.data(), deltas.size(),
+						&consumed);
+		int64_t period[2] = {0, 0};
+
+		if (consumed != payload.size() || n % 2 != 0) {
+			throw std::runtime_error(path + ": bad telemetry frame " +
+						 seq);
+		}
+		lost += dropped;
+		for (size_t i = 0; i < n; i += 2) {
+			period[0] += deltas[i];
+			period[1] += deltas[i + 1];
+			if (period[pick] > 0) {
+				cycles += static_cast<uint64_t>(period[pick]);
+				edges.push_back(static_cast<double>(cycles));
+			}
+		}
+	}
+
+	if (clock_hz <= 0.0) {
+		throw std::runtime_error(path + ": no TLM cps= line, "
+					 "give the clock");
+	}
+	if (edges.size() < 2) {
+		throw std::runtime_error(path + ": no telemetry frame");
+	}
+	if (lost) {
+		std::fprintf(stderr, "%s: %lu samples dropped on the device\n",
+			     path.c_str(), lost);
+	}
+	for (auto &t : edges) {
+		t /= clock_hz;
+	}
+
+	return edges;
+}
+
+} /* namespace */
+
+std::vector<double> load_edges(const std::string &path,
+			       const std::string &channel, double clock_hz)
+{
+	std::ifstream in(path, std::ios::binary);
+	char head[8] = {};
+
+	if (!in) {
+		throw std::runtime_error(path + ": cannot open");
+	}
+	in.read(head, sizeof(head));
+
+	if (std::memcmp(head, edgestore::magic, sizeof(head)) == 0) {
+		return store_edges(path, channel);
+	}
+	if (std::memcmp(head, "<SALEAE>", sizeof(head)) == 0 ||
+	    std::strncmp(head, "Time", 4) == 0 ||
+	    std::strncmp(head, "\"Time", 5) == 0 ||
+	    (path.size() > 4 && path.compare(path.size() - 4, 4, ".sal") == 0)) {
+		return read_rising_edges(path, channel);
+	}
+
+	return telemetry_edges(path, channel, clock_hz);
+}
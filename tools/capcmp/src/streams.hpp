@@ -0,0 +1,34 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CAPCMP_STREAMS_HPP_
+#define CAPCMP_STREAMS_HPP_
+
+#include <string>
+#include <vector>
+
+/**
+ * Rising edge times (s) of one signal, from any of:
+ *
+ * - a Saleae Logic 2 CSV or binary export (saleae_export.hpp); .sal
+ *   sessions must be exported first,
+ * - a columnar edge store (tools/edgestore),
+ * - a console log with "TLM" telemetry frames (app/src/telemetry.h).
+ *
+ * The source is told by the file contents. @p channel is the CSV column or
+ * store channel, by name or index, and "in" or "out" for telemetry.
+ *
+ * Telemetry carries periods only, its edges start at 0 and the samples
+ * dropped on the device shift all the later ones. The output period is
+ * sampled once per input edge, so the "out" edges only follow real time
+ * for a speed ratio of 1.
+ *
+ * @param clock_hz Period clock of telemetry logs without a "TLM cps=" line.
+ *
+ * @throws std::runtime_error on unreadable or malformed input.
+ */
+std::vector<double> load_edges(const std::string &path,
+			       const std::string &channel, double clock_hz);
+
+#endif /* CAPCMP_STREAMS_HPP_ */
@@ -0,0 +1,119 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "xcorr.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+using cplx = std::complex<double>;
+
+/* Fewer butterflies than this run on the calling thread. */
+constexpr size_t min_chunk = 1U << 12;
+
+} /* namespace */
+
+void fft(std::vector<cplx> &a, bool inverse, work_stealing_pool &pool)
+{
+	size_t n = a.size();
+	unsigned bits = 0;
+
+	while ((size_t{1} << bits) < n) {
+		bits++;
+	}
+
+	/* each index swaps with its bit reversal once, from the lower one */
+	parallel_for(pool, n, min_chunk, [&](size_t first, size_t last) {
+		for (size_t i = first; i < last; i++) {
+			size_t r = 0;
+
+			for (unsigned b = 0; b < bits; b++) {
+				r |= ((i >> b) & 1U) << (bits - 1 - b);
+			}
+			if (i < r) {
+				std::swap(a[i], a[r]);
+			}
+		}
+	});
+
+	std::vector<cplx> w(n / 2);
+	double sign = inverse ? 2.0 : -2.0;
+
+	parallel_for(pool, w.size(), min_chunk, [&](size_t first, size_t last) {
+		for (size_t k = first; k < last; k++) {
+			w[k] = std::polar(1.0, sign * M_PI * k / n);
+		}
+	});
+
+	for (size_t len = 2; len <= n; len <<= 1) {
+		size_t half = len / 2;
+		size_t step = n / len;
+
+		parallel_for(pool, n / 2, min_chunk, [&](size_t first, size_t last) {
+			for (size_t b = first; b < last; b++) {
+				size_t j = b % half;
+				size_t i = (b / half) * len + j;
+				cplx u = a[i];
+				cplx v = a[i + half] * w[j * step];
+
+				a[i] = u + v;
+				a[i + half] = u - v;
+			}
+		});
+	}
+
+	if (inverse) {
+		parallel_for(pool, n, min_chunk, [&](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				a[i] /= static_cast<double>(n);
+			}
+		});
+	}
+}
+
+std::vector<double> xcorr(const std::vector<double> &x,
+			  const std::vector<double> &y,
+			  work_stealing_pool &pool)
+{
+	size_t n = 1;
+
+	while (n < x.size() + y.size()) {
+		n <<= 1;
+	}
+
+	/* z = x + iy, then X = (Z[k] + Z*[-k]) / 2, Y = (Z[k] - Z*[-k]) / 2i */
+	std::vector<cplx> z(n);
+
+	for (size_t i = 0; i < x.size(); i++) {
+		z[i].real(x[i]);
+	}
+	for (size_t i = 0; i < y.size(); i++) {
+		z[i].imag(y[i]);
+	}
+	fft(z, false, pool);
+
+	std::vector<cplx> r(n);
+
+	parallel_for(pool, n, min_chunk, [&](size_t first, size_t last) {
+		for (size_t k = first; k < last; k++) {
+			cplx zk = z[k];
+			cplx zn = std::conj(z[(n - k) & (n - 1)]);
+			cplx xk = (zk + zn) * 0.5;
+			cplx yk = (zk - zn) * cplx(0.0, -0.5);
+
+			r[k] = std::conj(xk) * yk;
+		}
+	});
+	fft(r, true, pool);
+
+	std::vector<double> c(n);
+
+	for (size_t i = 0; i < n; i++) {
+		c[i] = r[i].real();
+	}
+
+	return c;
+}
@@ -0,0 +1,35 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CAPCMP_XCORR_HPP_
+#define CAPCMP_XCORR_HPP_
+
+#include <complex>
+#include <vector>
+
+#include "pool.hpp"
+
+/**
+ * In place radix-2 FFT, the butterflies of each stage split over @p pool.
+ *
+ * @param a Data, its size a power of 2.
+ * @param inverse Inverse transform, scaled by 1/size.
+ */
+void fft(std::vector<std::complex<double>> &a, bool inverse,
+	 work_stealing_pool &pool);
+
+/**
+ * Cross-correlation c[m] = sum x[n] y[n + m] of two real series.
+ *
+ * Both series go through a single complex FFT, zero padded so that nothing
+ * wraps around.
+ *
+ * @return c[m] at index m for 0 <= m < y.size(), c[-m] at index
+ *         size - m for 0 < m < x.size().
+ */
+std::vector<double> xcorr(const std::vector<double> &x,
+			  const std::vector<double> &y,
+			  work_stealing_pool &pool);
+
+#endif /* CAPCMP_XCORR_HPP_ */
@@ -0,0 +1,117 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "period_codec_batch.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+/* Decode a whole run of 1-byte codes, return values decoded. */
+size_t decode_short_run(const uint8_t *buf, size_t len, int32_t *out,
+			size_t max)
+{
+	size_t n = 0;
+
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi32(1);
+
+	while (n + 16 <= len && n + 16 <= max) {
+		__m128i b = _mm_loadu_si128(
+			reinterpret_cast<const __m128i *>(buf + n));
+
+		if (_mm_movemask_epi8(b) != 0) {
+			break;
+		}
+
+		__m128i lo = _mm_unpacklo_epi8(b, zero);
+		__m128i hi = _mm_unpackhi_epi8(b, zero);
+		__m128i v[4] = {
+			_mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+			_mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero),
+		};
+
+		for (int i = 0; i < 4; i++) {
+			/* (v >> 1) ^ -(v & 1) */
+			__m128i neg = _mm_sub_epi32(zero, _mm_and_si128(v[i], one));
+			__m128i d = _mm_xor_si128(_mm_srli_epi32(v[i], 1), neg);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + n + 4 * i),
+					 d);
+		}
+		n += 16;
+	}
+#endif
+
+	while (n + 8 <= len && n + 8 <= max) {
+		uint64_t w;
+
+		std::memcpy(&w, buf + n, sizeof(w));
+		if ((w & 0x8080808080808080ULL) != 0) {
+			break;
+		}
+		for (int i = 0; i < 8; i++) {
+			out[n + i] = pcodec_unzigzag(static_cast<uint8_t>(w >> (8 * i)));
+		}
+		n += 8;
+	}
+
+	return n;
+}
+
+} /* namespace */
+
+size_t pcodec_decode_deltas(const uint8_t *buf, size_t len, int32_t *out,
+			    size_t max, size_t *consumed)
+{
+	size_t pos = 0;
+	size_t n = 0;
+
+	while (n < max && pos < len) {
+		size_t run = decode_short_run(buf + pos, len - pos, out + n,
+					      max - n);
+
+		if (run != 0) {
+			pos += run;
+			n += run;
+			continue;
+		}
+
+		uint32_t zz;
+		size_t used = pcodec_varint_get(buf + pos, len - pos, &zz);
+
+		if (used == 0) {
+			break;
+		}
+		out[n++] = pcodec_unzigzag(zz);
+		pos += used;
+	}
+
+	*consumed = pos;
+
+	return n;
+}
+
+size_t pcodec_decode_batch(pcodec_state *st, const uint8_t *buf, size_t len,
+			   uint32_t *out, size_t max, size_t *consumed)
+{
+	/* deltas land in the output array, then get accumulated in place */
+	static_assert(sizeof(int32_t) == sizeof(uint32_t), "same width");
+	size_t n = pcodec_decode_deltas(buf, len, reinterpret_cast<int32_t *>(out),
+					max, consumed);
+	uint32_t prev = st->prev;
+
+	for (size_t i = 0; i < n; i++) {
+		prev += out[i];
+		out[i] = prev;
+	}
+	st->prev = prev;
+
+	return n;
+}
@@ -0,0 +1,49 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TOOLS_PERIOD_CODEC_BATCH_HPP_
+#define TOOLS_PERIOD_CODEC_BATCH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "codec/period_codec.h"
+
+/*
+ * Host batch decoders of the include/codec/period_codec.h format.
+ *
+ * Runs of single byte codes, by far the most common with steady periods, are
+ * decoded 16 at a time with SSE2 (8 at a time with 64-bit SWAR elsewhere);
+ * other codes fall back to pcodec_varint_get().
+ */
+
+/**
+ * Decode the zigzag values of a buffer, without the delta accumulation.
+ *
+ * Meant for interleaved streams, such as the input/output pairs of the
+ * telemetry and black-box records.
+ *
+ * @param buf Coded bytes.
+ * @param len Length of @p buf.
+ * @param out Decoded deltas.
+ * @param max Capacity of @p out.
+ * @param consumed Bytes decoded, may be less than @p len if @p out is full
+ *                 or @p buf ends with a truncated or malformed code.
+ *
+ * @return Number of values decoded.
+ */
+size_t pcodec_decode_deltas(const uint8_t *buf, size_t len, int32_t *out,
+			    size_t max, size_t *consumed);
+
+/**
+ * Decode a single period stream, same output as pcodec_decode() in a loop.
+ *
+ * @param st Coder state, updated.
+ *
+ * @return Number of periods decoded.
+ */
+size_t pcodec_decode_batch(pcodec_state *st, const uint8_t *buf, size_t len,
+			   uint32_t *out, size_t max, size_t *consumed);
+
+#endif /* TOOLS_PERIOD_CODEC_BATCH_HPP_ */
@@ -0,0 +1,176 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TOOLS_POOL_HPP_
+#define TOOLS_POOL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Thread pool with one task deque per worker.
+ *
+ * Tasks are dealt round-robin. A worker runs its own tasks newest first and,
+ * once out of work, steals the oldest task of another worker, so uneven task
+ * costs still keep every thread busy.
+ */
+class work_stealing_pool {
+public:
+	using task = std::function<void()>;
+
+	explicit work_stealing_pool(unsigned threads)
+	{
+		threads = threads ? threads : 1U;
+		for (unsigned i = 0; i < threads; i++) {
+			queues_.push_back(std::make_unique<queue>());
+		}
+		for (unsigned i = 0; i < threads; i++) {
+			workers_.emplace_back([this, i] { run(i); });
+		}
+	}
+
+	~work_stealing_pool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(idle_lock_);
+			stop_ = true;
+		}
+		idle_cv_.notify_all();
+		for (auto &w : workers_) {
+			w.join();
+		}
+	}
+
+	work_stealing_pool(const work_stealing_pool &) = delete;
+	work_stealing_pool &operator=(const work_stealing_pool &) = delete;
+
+	void submit(task t)
+	{
+		auto &q = *queues_[next_++ % queues_.size()];
+
+		pending_++;
+		{
+			std::lock_guard<std::mutex> lock(q.lock);
+			q.tasks.push_back(std::move(t));
+		}
+		/* a missed wake-up only costs the idle poll period */
+		idle_cv_.notify_one();
+	}
+
+	/** Block until every submitted task has run. */
+	void wait()
+	{
+		std::unique_lock<std::mutex> lock(idle_lock_);
+
+		done_cv_.wait(lock, [this] { return pending_ == 0; });
+	}
+
+	unsigned size() const
+	{
+		return static_cast<unsigned>(workers_.size());
+	}
+
+private:
+	struct queue {
+		std::mutex lock;
+		std::deque<task> tasks;
+	};
+
+	bool pop_local(size_t self, task &t)
+	{
+		auto &q = *queues_[self];
+		std::lock_guard<std::mutex> lock(q.lock);
+
+		if (q.tasks.empty()) {
+			return false;
+		}
+		t = std::move(q.tasks.back());
+		q.tasks.pop_back();
+
+		return true;
+	}
+
+	bool steal(size_t self, task &t)
+	{
+		for (size_t i = 1; i < queues_.size(); i++) {
+			auto &q = *queues_[(self + i) % queues_.size()];
+			std::lock_guard<std::mutex> lock(q.lock);
+
+			if (!q.tasks.empty()) {
+				t = std::move(q.tasks.front());
+				q.tasks.pop_front();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void run(size_t self)
+	{
+		task t;
+
+		for (;;) {
+			if (pop_local(self, t) || steal(self, t)) {
+				t();
+				t = nullptr;
+				if (--pending_ == 0) {
+					std::lock_guard<std::mutex> lock(idle_lock_);
+					done_cv_.notify_all();
+				}
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(idle_lock_);
+			if (stop_) {
+				return;
+			}
+			idle_cv_.wait_for(lock, std::chrono::milliseconds(10));
+		}
+	}
+
+	std::vector<std::unique_ptr<queue>> queues_;
+	std::vector<std::thread> workers_;
+	std::atomic<size_t> next_{0};
+	std::atomic<size_t> pending_{0};
+	std::mutex idle_lock_;
+	std::condition_variable idle_cv_;
+	std::condition_variable done_cv_;
+	bool stop_ = false;
+};
+
+/**
+ * Run fn(first, last) over [0, n) in chunks on @p pool and wait for them.
+ *
+ * Small ranges run on the calling thread.
+ *
+ * @param min_chunk Smallest chunk worth a task.
+ */
+template <typename F>
+void parallel_for(work_stealing_pool &pool, size_t n, size_t min_chunk, F fn)
+{
+	if (n <= min_chunk || pool.size() == 1) {
+		fn(size_t{0}, n);
+		return;
+	}
+
+	/* a few chunks per thread, for stealing to balance the load */
+	size_t chunk = std::max(min_chunk, n / (4 * pool.size()));
+
+	for (size_t first = 0; first < n; first += chunk) {
+		pool.submit([&fn, first, chunk, n] {
+			fn(first, std::min(first + chunk, n));
+		});
+	}
+	pool.wait();
+}
+
+#endif /* TOOLS_POOL_HPP_ */
@@ -0,0 +1,179 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "saleae_export.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+bool has_suffix(const std::string &s, const std::string &suffix)
+{
+	return s.size() >= suffix.size() &&
+	       s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::vector<std::string> split_csv(const std::string &line)
+{
+	std::vector<std::string> cols;
+	std::stringstream ss(line);
+	std::string col;
+
+	while (std::getline(ss, col, ',')) {
+		if (!col.empty() && col.back() == '\r') {
+			col.pop_back();
+		}
+		if (col.size() >= 2 && col.front() == '"' && col.back() == '"') {
+			col = col.substr(1, col.size() - 2);
+		}
+		cols.push_back(col);
+	}
+
+	return cols;
+}
+
+std::vector<channel_edges> read_csv(const std::string &path)
+{
+	std::ifstream in(path);
+	std::vector<channel_edges> channels;
+	std::vector<int> levels;
+	std::string line;
+
+	if (!in || !std::getline(in, line)) {
+		throw std::runtime_error(path + ": cannot read CSV header");
+	}
+
+	auto header = split_csv(line);
+	for (size_t i = 1; i < header.size(); i++) {
+		channels.push_back({header[i], 0, {}});
+	}
+	if (channels.empty()) {
+		throw std::runtime_error(path + ": no channel in CSV header");
+	}
+	levels.assign(channels.size(), -1);
+
+	while (std::getline(in, line)) {
+		auto cols = split_csv(line);
+
+		if (cols.size() <= channels.size()) {
+			continue;
+		}
+
+		double t = std::stod(cols[0]);
+		for (size_t c = 0; c < channels.size(); c++) {
+			int level = std::stoi(cols[c + 1]) != 0;
+
+			if (levels[c] < 0) {
+				channels[c].initial_level = level;
+			} else if (level != levels[c]) {
+				channels[c].transitions.push_back(t);
+			}
+			levels[c] = level;
+		}
+	}
+
+	return channels;
+}
+
+template <typename T> T read_raw(std::ifstream &in, const std::string &path)
+{
+	T v;
+
+	if (!in.read(reinterpret_cast<char *>(&v), sizeof(v))) {
+		throw std::runtime_error(path + ": truncated binary export");
+	}
+
+	return v;
+}
+
+/* Logic 2 binary export, digital channel, versions 0 and 1. */
+channel_edges read_bin(const std::string &path)
+{
+	std::ifstream in(path, std::ios::binary);
+	channel_edges ch{};
+	char id[8];
+
+	if (!in.read(id, sizeof(id)) || std::memcmp(id, "<SALEAE>", 8) != 0) {
+		throw std::runtime_error(path + ": not a Saleae binary export");
+	}
+
+	int32_t version = read_raw<int32_t>(in, path);
+	int32_t type = read_raw<int32_t>(in, path);
+	if (version > 1 || type != 0) {
+		throw std::runtime_error(path + ": unsupported export type");
+	}
+
+	ch.initial_level = read_raw<uint32_t>(in, path) != 0;
+	(void)read_raw<double>(in, path); /* begin time */
+	(void)read_raw<double>(in, path); /* end time */
+	uint64_t count = read_raw<uint64_t>(in, path);
+
+	ch.transitions.reserve(count);
+	for (uint64_t i = 0; i < count; i++) {
+		ch.transitions.push_back(read_raw<double>(in, path));
+	}
+
+	size_t slash = path.find_last_of('/');
+	ch.name = path.substr(slash == std::string::npos ? 0 : slash + 1);
+	ch.name = ch.name.substr(0, ch.name.size() - 4);
+
+	return ch;
+}
+
+} /* namespace */
+
+std::vector<channel_edges> read_export(const std::string &path)
+{
+	if (has_suffix(path, ".sal")) {
+		throw std::runtime_error(path + ": .sal sessions cannot be read, "
+					 "export the channels as CSV or binary");
+	}
+	if (has_suffix(path, ".bin")) {
+		return {read_bin(path)};
+	}
+
+	return read_csv(path);
+}
+
+std::vector<double> read_rising_edges(const std::string &path,
+				      const std::string &channel)
+{
+	auto channels = read_export(path);
+	const channel_edges *ch = nullptr;
+
+	for (const auto &c : channels) {
+		if (c.name == channel) {
+			ch = &c;
+		}
+	}
+	if (ch == nullptr && channels.size() == 1) {
+		ch = &channels[0];
+	}
+	if (ch == nullptr) {
+		char *end;
+		unsigned long idx = std::strtoul(channel.c_str(), &end, 10);
+
+		if (*end != '\0' || idx >= channels.size()) {
+			throw std::runtime_error(path + ": no channel " + channel);
+		}
+		ch = &channels[idx];
+	}
+
+	std::vector<double> edges;
+	int level = ch->initial_level;
+
+	for (double t : ch->transitions) {
+		level ^= 1;
+		if (level) {
+			edges.push_back(t);
+		}
+	}
+
+	return edges;
+}
@@ -0,0 +1,46 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TOOLS_SALEAE_EXPORT_HPP_
+#define TOOLS_SALEAE_EXPORT_HPP_
+
+#include <string>
+#include <vector>
+
+/*
+ * The .sal session files are an undocumented internal format: export the
+ * channels from Logic 2 first, either as CSV ("Time [s],<ch>,<ch>...", one
+ * row per transition) or as binary (one digital_<n>.bin file per channel).
+ */
+
+/** Transitions of one digital channel. */
+struct channel_edges {
+	std::string name;
+	/** Level before the first transition. */
+	int initial_level;
+	/** Transition times (s), the level toggles at each one. */
+	std::vector<double> transitions;
+};
+
+/**
+ * Read every channel of a Saleae Logic 2 CSV or binary export.
+ *
+ * Binary exports hold a single channel, named after the file.
+ *
+ * @throws std::runtime_error on unreadable or malformed input.
+ */
+std::vector<channel_edges> read_export(const std::string &path);
+
+/**
+ * Rising edge times (s) of one channel of a Saleae Logic 2 export.
+ *
+ * @param path CSV or binary export.
+ * @param channel Column name or index for CSV, ignored for binary files.
+ *
+ * @throws std::runtime_error on unreadable or malformed input.
+ */
+std::vector<double> read_rising_edges(const std::string &path,
+				      const std::string &channel);
+
+#endif /* TOOLS_SALEAE_EXPORT_HPP_ */
@@ -0,0 +1,136 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * Columnar, memory-mappable store of logic analyzer edges.
+ *
+ * Layout (little-endian, every section 8-byte aligned):
+ *
+ *   file_header
+ *   channel_header[channel_count]
+ *   per channel:
+ *     block_index[block_count]   first edge time and data offset per block
+ *     block data                 varint deltas between successive edges
+ *
+ * Edge times are integer ticks of file_header.tick_hz. Each block holds up
+ * to channel_header.block_edges edges: the first time is in the index, the
+ * others are unsigned LEB128 deltas (include/codec/period_codec.h). A range query binary searches the
+ * index and decodes from one block on, so it costs O(log n) plus the
+ * output size, without reading the rest of the file.
+ */
+
+#ifndef TOOLS_EDGESTORE_HPP_
+#define TOOLS_EDGESTORE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace edgestore {
+
+constexpr char magic[8] = {'E', 'D', 'G', 'S', 'T', 'O', 'R', 'E'};
+constexpr uint32_t version = 1;
+
+struct file_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t channel_count;
+	uint64_t tick_hz;
+};
+
+struct channel_header {
+	char name[32];
+	uint64_t edge_count;
+	uint64_t block_count;
+	/** Offsets from the start of the file. */
+	uint64_t index_offset;
+	uint64_t data_offset;
+	uint64_t data_size;
+	uint32_t block_edges;
+	/** Level before the first edge, the level toggles at each edge. */
+	uint32_t initial_level;
+};
+
+struct block_index {
+	uint64_t first_time;
+	/** Offset in the channel data. */
+	uint64_t offset;
+};
+
+static_assert(sizeof(file_header) == 24, "packed layout");
+static_assert(sizeof(channel_header) == 80, "packed layout");
+static_assert(sizeof(block_index) == 16, "packed layout");
+
+/** Input of the writer: one channel. */
+struct channel {
+	std::string name;
+	uint32_t initial_level;
+	/** Edge times in ticks, increasing. */
+	std::vector<uint64_t> times;
+};
+
+/**
+ * Write a store.
+ *
+ * @throws std::runtime_error on I/O error or non increasing times.
+ */
+void write(const std::string &path, uint64_t tick_hz,
+	   const std::vector<channel> &channels, uint32_t block_edges = 256);
+
+/** An edge returned by queries. */
+struct edge {
+	uint64_t time;
+	/** Level after the edge. */
+	uint32_t level;
+};
+
+/** Read-only view of a store, mapped in memory. */
+class reader {
+public:
+	/** @throws std::runtime_error if the file is not a valid store. */
+	explicit reader(const std::string &path);
+	~reader();
+
+	reader(const reader &) = delete;
+	reader &operator=(const reader &) = delete;
+
+	uint64_t tick_hz() const
+	{
+		return header_->tick_hz;
+	}
+
+	size_t channel_count() const
+	{
+		return header_->channel_count;
+	}
+
+	const channel_header &channel(size_t idx) const
+	{
+		return channels_[idx];
+	}
+
+	/** @return Channel index, or -1 if there is no such channel. */
+	int find(const std::string &name) const;
+
+	/** Edges of channel @p ch with @p t0 <= time < @p t1 (ticks). */
+	std::vector<edge> edges(size_t ch, uint64_t t0, uint64_t t1) const;
+
+	/**
+	 * Periods (ticks) between rising edges of channel @p ch which both
+	 * lie in [@p t0, @p t1).
+	 */
+	std::vector<uint64_t> periods(size_t ch, uint64_t t0, uint64_t t1) const;
+
+private:
+	const uint8_t *base_ = nullptr;
+	size_t size_ = 0;
+	const file_header *header_ = nullptr;
+	const channel_header *channels_ = nullptr;
+};
+
+} /* namespace edgestore */
+
+#endif /* TOOLS_EDGESTORE_HPP_ */
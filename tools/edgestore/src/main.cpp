@@ -0,0 +1,161 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Edge store conversion and query tool.
+ *
+ *   edgestore convert [--tick-hz HZ] [--block N] <out> <export>...
+ *   edgestore info <store>
+ *   edgestore edges <store> <channel> <t0_s> <t1_s>
+ *   edgestore periods <store> <channel> <t0_s> <t1_s>
+ *
+ * Exports are Saleae Logic 2 CSV or binary files, see saleae_export.hpp.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "edgestore.hpp"
+#include "saleae_export.hpp"
+
+namespace {
+
+void usage()
+{
+	std::fprintf(stderr,
+		"usage: edgestore convert [--tick-hz HZ] [--block N] <out> <export>...\n"
+		"       edgestore info <store>\n"
+		"       edgestore edges <store> <channel> <t0_s> <t1_s>\n"
+		"       edgestore periods <store> <channel> <t0_s> <t1_s>\n");
+}
+
+int convert(const std::vector<std::string> &args)
+{
+	uint64_t tick_hz = 1000000000U;
+	uint32_t block = 256;
+	std::vector<std::string> files;
+
+	for (size_t i = 0; i < args.size(); i++) {
+		if (args[i] == "--tick-hz" && i + 1 < args.size()) {
+			tick_hz = std::stoull(args[++i]);
+		} else if (args[i] == "--block" && i + 1 < args.size()) {
+			block = std::stoul(args[++i]);
+		} else {
+			files.push_back(args[i]);
+		}
+	}
+	if (files.size() < 2) {
+		usage();
+		return 2;
+	}
+
+	std::vector<edgestore::channel> channels;
+
+	for (size_t f = 1; f < files.size(); f++) {
+		for (const auto &ch : read_export(files[f])) {
+			edgestore::channel out{ch.name,
+					       static_cast<uint32_t>(ch.initial_level),
+					       {}};
+
+			out.times.reserve(ch.transitions.size());
+			for (double t : ch.transitions) {
+				if (t < 0.0) {
+					throw std::runtime_error(
+						files[f] + ": negative edge time");
+				}
+				out.times.push_back(static_cast<uint64_t>(
+					std::llround(t * tick_hz)));
+			}
+			channels.push_back(std::move(out));
+		}
+	}
+
+	edgestore::write(files[0], tick_hz, channels, block);
+	for (const auto &ch : channels) {
+		std::printf("%s: %zu edges\n", ch.name.c_str(), ch.times.size());
+	}
+
+	return 0;
+}
+
+int info(const std::string &path)
+{
+	edgestore::reader r(path);
+
+	std::printf("tick %llu Hz, %zu channels\n",
+		    (unsigned long long)r.tick_hz(), r.channel_count());
+	for (size_t c = 0; c < r.channel_count(); c++) {
+		const auto &h = r.channel(c);
+
+		std::printf("%-32.32s %12llu edges %8llu blocks %10llu bytes\n",
+			    h.name, (unsigned long long)h.edge_count,
+			    (unsigned long long)h.block_count,
+			    (unsigned long long)h.data_size);
+	}
+
+	return 0;
+}
+
+int query(const std::string &cmd, const std::vector<std::string> &args)
+{
+	if (args.size() != 4) {
+		usage();
+		return 2;
+	}
+
+	edgestore::reader r(args[0]);
+	int ch = r.find(args[1]);
+	if (ch < 0) {
+		throw std::runtime_error(args[0] + ": no channel " + args[1]);
+	}
+
+	double hz = static_cast<double>(r.tick_hz());
+	auto t0 = static_cast<uint64_t>(std::llround(std::stod(args[2]) * hz));
+	auto t1 = static_cast<uint64_t>(std::llround(std::stod(args[3]) * hz));
+
+	if (cmd == "edges") {
+		for (const auto &e : r.edges(ch, t0, t1)) {
+			std::printf("%.9f %u\n", e.time / hz, e.level);
+		}
+	} else {
+		for (uint64_t p : r.periods(ch, t0, t1)) {
+			std::printf("%.9f\n", p / hz);
+		}
+	}
+
+	return 0;
+}
+
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+	if (argc < 3) {
+		usage();
+		return 2;
+	}
+
+	std::string cmd = argv[1];
+	std::vector<std::string> args(argv + 2, argv + argc);
+
+	try {
+		if (cmd == "convert") {
+			return convert(args);
+		} else if (cmd == "info") {
+			return info(args[0]);
+		} else if (cmd == "edges" || cmd == "periods") {
+			return query(cmd, args);
+		}
+	} catch (const std::exception &e) {
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+
+	usage();
+	return 2;
+}
@@ -0,0 +1,169 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "edgestore.hpp"
+
+#include <codec/period_codec.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace edgestore {
+
+namespace {
+
+uint64_t get_varint(const uint8_t *&p, const uint8_t *end)
+{
+	uint64_t v;
+	size_t len = pcodec_varint_get64(p, end - p, &v);
+
+	if (len == 0) {
+		throw std::runtime_error("corrupted edge block");
+	}
+	p += len;
+
+	return v;
+}
+
+} /* namespace */
+
+reader::reader(const std::string &path)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	struct stat st;
+
+	if (fd < 0) {
+		throw std::runtime_error(path + ": cannot open");
+	}
+	if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(file_header)) {
+		close(fd);
+		throw std::runtime_error(path + ": not an edge store");
+	}
+
+	size_ = static_cast<size_t>(st.st_size);
+	void *map = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		throw std::runtime_error(path + ": mmap failed");
+	}
+	base_ = static_cast<const uint8_t *>(map);
+	header_ = reinterpret_cast<const file_header *>(base_);
+	channels_ = reinterpret_cast<const channel_header *>(header_ + 1);
+
+	bool valid = std::memcmp(header_->magic, magic, sizeof(magic)) == 0 &&
+		     header_->version == version &&
+		     sizeof(file_header) + header_->channel_count *
+		     sizeof(channel_header) <= size_;
+
+	for (size_t c = 0; valid && c < header_->channel_count; c++) {
+		const auto &h = channels_[c];
+
+		valid = h.index_offset % 8U == 0 &&
+			h.index_offset + h.block_count * sizeof(block_index) <=
+			h.data_offset &&
+			h.data_offset + h.data_size <= size_;
+	}
+	if (!valid) {
+		munmap(const_cast<uint8_t *>(base_), size_);
+		throw std::runtime_error(path + ": not an edge store");
+	}
+}
+
+reader::~reader()
+{
+	munmap(const_cast<uint8_t *>(base_), size_);
+}
+
+int reader::find(const std::string &name) const
+{
+	for (size_t c = 0; c < channel_count(); c++) {
+		if (std::strncmp(channels_[c].name, name.c_str(),
+				 sizeof(channels_[c].name)) == 0) {
+			return static_cast<int>(c);
+		}
+	}
+
+	return -1;
+}
+
+std::vector<edge> reader::edges(size_t ch, uint64_t t0, uint64_t t1) const
+{
+	const channel_header &h = channels_[ch];
+	const auto *index = reinterpret_cast<const block_index *>(
+		base_ + h.index_offset);
+	const uint8_t *data = base_ + h.data_offset;
+	std::vector<edge> out;
+
+	if (h.block_count == 0 || t1 <= t0) {
+		return out;
+	}
+
+	/* last block starting at or before t0 */
+	const block_index *blk = std::upper_bound(
+		index, index + h.block_count, t0,
+		[](uint64_t t, const block_index &b) { return t < b.first_time; });
+	if (blk != index) {
+		blk--;
+	}
+
+	for (; blk < index + h.block_count; blk++) {
+		uint64_t n = blk - index;
+		uint64_t first = n * h.block_edges;
+		uint64_t count = std::min<uint64_t>(h.block_edges,
+						    h.edge_count - first);
+		const uint8_t *p = data + blk->offset;
+		const uint8_t *end = data + h.data_size;
+		uint64_t t = blk->first_time;
+
+		if (t >= t1) {
+			break;
+		}
+		for (uint64_t i = 0; i < count; i++) {
+			if (i > 0) {
+				t += get_varint(p, end);
+			}
+			if (t >= t1) {
+				return out;
+			}
+			if (t >= t0) {
+				/* the level toggles at every edge */
+				uint32_t level = h.initial_level ^
+						 ((first + i + 1U) & 1U);
+
+				out.push_back({t, level});
+			}
+		}
+	}
+
+	return out;
+}
+
+std::vector<uint64_t> reader::periods(size_t ch, uint64_t t0,
+				      uint64_t t1) const
+{
+	std::vector<uint64_t> out;
+	uint64_t last = 0;
+	bool has_last = false;
+
+	for (const edge &e : edges(ch, t0, t1)) {
+		if (e.level == 0U) {
+			continue;
+		}
+		if (has_last) {
+			out.push_back(e.time - last);
+		}
+		last = e.time;
+		has_last = true;
+	}
+
+	return out;
+}
+
+} /* namespace edgestore */
@@ -0,0 +1,106 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "edgestore.hpp"
+
+#include <codec/period_codec.h>
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace edgestore {
+
+namespace {
+
+void put_varint(std::vector<uint8_t> &out, uint64_t v)
+{
+	uint8_t buf[PCODEC_MAX_BYTES64];
+
+	out.insert(out.end(), buf, buf + pcodec_varint_put64(buf, v));
+}
+
+uint64_t align8(uint64_t v)
+{
+	return (v + 7U) & ~uint64_t(7U);
+}
+
+struct encoded {
+	std::vector<block_index> index;
+	std::vector<uint8_t> data;
+};
+
+encoded encode(const channel &ch, uint32_t block_edges)
+{
+	encoded enc;
+
+	for (size_t i = 0; i < ch.times.size(); i++) {
+		if (i % block_edges == 0) {
+			enc.index.push_back({ch.times[i], enc.data.size()});
+			continue;
+		}
+		if (ch.times[i] < ch.times[i - 1]) {
+			throw std::runtime_error(ch.name + ": edge times go back");
+		}
+		put_varint(enc.data, ch.times[i] - ch.times[i - 1]);
+	}
+
+	return enc;
+}
+
+} /* namespace */
+
+void write(const std::string &path, uint64_t tick_hz,
+	   const std::vector<channel> &channels, uint32_t block_edges)
+{
+	std::vector<channel_header> headers(channels.size());
+	std::vector<encoded> encs;
+	file_header fh{};
+	uint64_t offset;
+
+	if (block_edges == 0) {
+		throw std::runtime_error("block size must not be 0");
+	}
+
+	std::memcpy(fh.magic, magic, sizeof(fh.magic));
+	fh.version = version;
+	fh.channel_count = static_cast<uint32_t>(channels.size());
+	fh.tick_hz = tick_hz;
+
+	offset = sizeof(fh) + headers.size() * sizeof(channel_header);
+	for (size_t c = 0; c < channels.size(); c++) {
+		auto &h = headers[c];
+
+		encs.push_back(encode(channels[c], block_edges));
+		std::strncpy(h.name, channels[c].name.c_str(), sizeof(h.name) - 1);
+		h.edge_count = channels[c].times.size();
+		h.block_count = encs[c].index.size();
+		h.block_edges = block_edges;
+		h.initial_level = channels[c].initial_level;
+		h.index_offset = offset;
+		offset += h.block_count * sizeof(block_index);
+		h.data_offset = offset;
+		h.data_size = encs[c].data.size();
+		offset = align8(offset + h.data_size);
+	}
+
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	static const char pad[8] = {};
+
+	out.write(reinterpret_cast<const char *>(&fh), sizeof(fh));
+	out.write(reinterpret_cast<const char *>(headers.data()),
+		  headers.size() * sizeof(channel_header));
+	for (size_t c = 0; c < channels.size(); c++) {
+		out.write(reinterpret_cast<const char *>(encs[c].index.data()),
+			  encs[c].index.size() * sizeof(block_index));
+		out.write(reinterpret_cast<const char *>(encs[c].data.data()),
+			  encs[c].data.size());
+		out.write(pad, align8(encs[c].data.size()) - encs[c].data.size());
+	}
+	if (!out) {
+		throw std::runtime_error(path + ": write failed");
+	}
+}
+
+} /* namespace edgestore */
@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: Apache-2.0
+"""Flash and RAM footprint by subsystem, checked against budgets.
+
+Reads the GNU ld map file of a Zephyr build and attributes every input
+section to a subsystem from the archive or object it comes from. Sections
+located in RAM with a load address in flash (initialized data) count in
+both. Stacks and buffers count in the subsystem that defines them.
+
+    footprint.py zephyr.map [--budget ic:ram=1024] ...
+
+Budgets are SUBSYSTEM:REGION=BYTES, REGION being flash or ram and
+SUBSYSTEM one of the table rows or "total". The exit status is 1 when a
+budget is exceeded, so that the build fails.
+"""
+
+import argparse
+import re
+import sys
+
+# First match wins, on the archive/object path of the input section.
+SUBSYSTEMS = [
+    ('ic', re.compile(r'drivers__ic\.a|/drivers/ic/')),
+    ('app', re.compile(r'(^|/)app/libapp\.a|speedxform')),
+    ('shell', re.compile(r'subsys__shell')),
+    ('logging', re.compile(r'subsys__logging')),
+    ('kernel', re.compile(r'(^|/)kernel/libkernel\.a')),
+    ('libc', re.compile(r'libc|libgcc|libm\.a|picolibc|newlib')),
+]
+OTHER = 'other'
+REGIONS = ('flash', 'ram')
+
+# Zero initialized input sections: ld prints a load address for their
+# output section all the same, but they take no flash.
+RE_NOBITS = re.compile(r'^(\.bss|\.sbss|\.tbss|\.noinit|COMMON)')
+
+RE_REGION = re.compile(r'^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)')
+RE_OUTPUT = re.compile(r'^([^\s*]\S*)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)'
+                       r'(?:\s+load address 0x([0-9a-fA-F]+))?)?\s*$')
+RE_INPUT = re.compile(r'^ (\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)'
+                      r'(?:\s+(.*))?)?$')
+RE_CONT = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.*)$')
+RE_OUTPUT_CONT = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)'
+                            r'(?:\s+load address 0x([0-9a-fA-F]+))?\s*$')
+
+
+def subsystem(obj):
+    for name, pattern in SUBSYSTEMS:
+        if pattern.search(obj):
+            return name
+    return OTHER
+
+
+def region_kind(name):
+    name = name.upper()
+    if 'FLASH' in name or 'ROM' in name:
+        return 'flash'
+    if 'RAM' in name:
+        return 'ram'
+    return None
+
+
+class MapFile:
+    def __init__(self, path):
+        # (kind, origin, length) of the flash and RAM memory regions
+        self.regions = []
+        self.usage = {}
+
+        with open(path, encoding='utf-8', errors='replace') as f:
+            lines = f.read().splitlines()
+
+        # the memory map follows the memory configuration
+        it = iter(lines)
+        for line in it:
+            if line.startswith('Memory Configuration'):
+                self._regions(it)
+                self._sections(it)
+
+        if not self.regions:
+            raise ValueError(f'{path}: no memory configuration')
+
+    def _regions(self, it):
+        for line in it:
+            if line.startswith('Linker script and memory map'):
+                break
+            m = RE_REGION.match(line)
+            if m and region_kind(m.group(1)):
+                self.regions.append((region_kind(m.group(1)),
+                                     int(m.group(2), 16),
+                                     int(m.group(3), 16)))
+
+    def region_of(self, addr):
+        for kind, origin, length in self.regions:
+            if origin <= addr < origin + length:
+                return kind
+        return None
+
+    def size(self, kind):
+        return sum(length for k, _, length in self.regions if k == kind)
+
+    def _add(self, section, obj, size, kinds):
+        """Charge an input section, return the regions charged."""
+        sub = subsystem(obj)
+        if RE_NOBITS.match(section):
+            kinds = kinds[:1]
+        for kind in kinds:
+            used = self.usage.setdefault(sub, dict.fromkeys(REGIONS, 0))
+            used[kind] += size
+        return kinds
+
+    def _sections(self, lines):
+        kinds = ()
+        pending_input = None
+        pending_output = False
+        # regions of the last input section, for the padding after it
+        fill_kinds = ()
+
+        for line in lines:
+            # a section name alone on its line, its address on the next
+            if pending_output:
+                pending_output = False
+                m = RE_OUTPUT_CONT.match(line)
+                if m:
+                    kinds = self._output_kinds(m.group(1), m.group(3))
+                    continue
+
+            if pending_input is not None:
+                section, pending_input = pending_input, None
+                m = RE_CONT.match(line)
+                if m:
+                    if kinds:
+                        fill_kinds = self._add(section, m.group(3).strip(),
+                                               int(m.group(2), 16), kinds)
+                    continue
+
+            if not line or line.startswith('LOAD ') or \
+               line.startswith('OUTPUT('):
+                continue
+
+            if not line[0].isspace():
+                m = RE_OUTPUT.match(line)
+                if not m or m.group(1) == '/DISCARD/':
+                    kinds = ()
+                elif m.group(2) is None:
+                    pending_output = True
+                else:
+                    kinds = self._output_kinds(m.group(2), m.group(4))
+                fill_kinds = ()
+                continue
+
+            m = RE_INPUT.match(line)
+            if not m or m.group(1).startswith('*'):
+                # *fill* and input patterns
+                if m and m.group(1) == '*fill*' and m.group(3) and kinds:
+                    self._add('', '', int(m.group(3), 16),
+                              fill_kinds or kinds[:1])
+                continue
+            if m.group(2) is None:
+                pending_input = m.group(1)
+            elif kinds:
+                fill_kinds = self._add(m.group(1), (m.group(4) or '').strip(),
+                                       int(m.group(3), 16), kinds)
+
+    def _output_kinds(self, vma, lma):
+        """Regions charged for an output section, from hex addresses."""
+        kind = self.region_of(int(vma, 16))
+        if kind is None:
+            return ()
+        if lma is not None:
+            load_kind = self.region_of(int(lma, 16))
+            if load_kind is not None and load_kind != kind:
+                return (kind, load_kind)
+        return (kind,)
+
+
+def parse_budget(text):
+    m = re.fullmatch(r'(\w+):(flash|ram)=(\d+)', text)
+    if not m:
+        raise argparse.ArgumentTypeError(f'bad budget: {text}')
+    return m.group(1), m.group(2), int(m.group(3))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('map', help='linker map file')
+    parser.add_argument('--budget', type=parse_budget, action='append',
+                        default=[], metavar='SUB:REGION=BYTES',
+                        help='fail if SUB uses more than BYTES of REGION, '
+                             '0 for no budget')
+    args = parser.parse_args()
+
+    try:
+        mf = MapFile(args.map)
+    except (OSError, ValueError) as e:
+        print(f'footprint: {e}', file=sys.stderr)
+        return 2
+
+    names = [name for name, _ in SUBSYSTEMS] + [OTHER]
+    total = dict.fromkeys(REGIONS, 0)
+    zero = dict.fromkeys(REGIONS, 0)
+
+    print(f'{"subsystem":<10} {"flash":>8} {"ram":>8}')
+    for name in names:
+        used = mf.usage.get(name, zero)
+        print(f'{name:<10} {used["flash"]:>8} {used["ram"]:>8}')
+        for kind in REGIONS:
+            total[kind] += used[kind]
+    print(f'{"total":<10} {total["flash"]:>8} {total["ram"]:>8}')
+    print(f'{"of":<10} {mf.size("flash"):>8} {mf.size("ram"):>8}')
+
+    failed = False
+    for name, kind, limit in args.budget:
+        if limit == 0:
+            continue
+        if name != 'total' and name not in names:
+            print(f'footprint: unknown subsystem {name}', file=sys.stderr)
+            return 2
+        used = total[kind] if name == 'total' else \
+            mf.usage.get(name, zero)[kind]
+        if used > limit:
+            print(f'footprint: {name} uses {used} B of {kind}, over its '
+                  f'budget of {limit} B', file=sys.stderr)
+            failed = True
+
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,190 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Period codec round-trip check and throughput benchmark.
+ *
+ * Every stream is coded with the firmware encoder, then decoded with both the
+ * scalar decoder and the host batch decoder, which must give back the input.
+ * Exits with 1 on the first mismatch.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "period_codec_batch.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct stream {
+	std::string name;
+	std::vector<uint32_t> periods;
+};
+
+std::vector<uint8_t> encode(const std::vector<uint32_t> &periods)
+{
+	std::vector<uint8_t> out(periods.size() * PCODEC_MAX_BYTES);
+	pcodec_state st{};
+	size_t len = 0;
+
+	for (uint32_t p : periods) {
+		len += pcodec_encode(&st, &out[len], p);
+	}
+	out.resize(len);
+
+	return out;
+}
+
+/* Random walk around @p base with steps up to @p step. */
+stream walk(const char *name, size_t n, uint32_t base, uint32_t step)
+{
+	std::mt19937 rng(1);
+	std::uniform_int_distribution<int64_t> d(-int64_t(step), step);
+	stream s{name, {}};
+	int64_t p = base;
+
+	for (size_t i = 0; i < n; i++) {
+		p = std::max<int64_t>(1, std::min<int64_t>(UINT32_MAX, p + d(rng)));
+		s.periods.push_back(static_cast<uint32_t>(p));
+	}
+
+	return s;
+}
+
+stream extremes()
+{
+	stream s{"extremes", {0, UINT32_MAX, 0, 1, 0x80000000U, 0x7fffffffU,
+			      0x80000000U, 0, 127, 128, 16383, 16384}};
+	std::mt19937 rng(2);
+
+	for (int i = 0; i < 100000; i++) {
+		s.periods.push_back(rng());
+	}
+
+	return s;
+}
+
+bool check(const stream &s, const std::vector<uint8_t> &coded)
+{
+	std::vector<uint32_t> out(s.periods.size() + 1);
+	pcodec_state st{};
+	size_t pos = 0;
+
+	for (size_t i = 0; i < s.periods.size(); i++) {
+		uint32_t v = 0;
+		size_t n = pcodec_decode(&st, &coded[pos], coded.size() - pos, &v);
+
+		if (n == 0 || v != s.periods[i]) {
+			std::printf("%s: scalar mismatch at %zu\n", s.name.c_str(), i);
+			return false;
+		}
+		pos += n;
+	}
+
+	st = {};
+	size_t consumed;
+	size_t n = pcodec_decode_batch(&st, coded.data(), coded.size(),
+				       out.data(), out.size(), &consumed);
+
+	if (n != s.periods.size() || consumed != coded.size() ||
+	    !std::equal(s.periods.begin(), s.periods.end(), out.begin())) {
+		std::printf("%s: batch mismatch\n", s.name.c_str());
+		return false;
+	}
+
+	/* a truncated code must stop the decoder, not be misread */
+	if (coded.size() > 1 && coded[coded.size() - 2] & 0x80U) {
+		st = {};
+		pcodec_decode_batch(&st, coded.data(), coded.size() - 1,
+				    out.data(), out.size(), &consumed);
+		if (consumed > coded.size() - 1) {
+			std::printf("%s: read past truncated input\n",
+				    s.name.c_str());
+			return false;
+		}
+	}
+
+	return true;
+}
+
+template <typename F> double mvalues_per_sec(size_t values, F &&fn)
+{
+	double best = std::numeric_limits<double>::infinity();
+
+	for (int rep = 0; rep < 5; rep++) {
+		auto t0 = clock_type::now();
+		fn();
+		std::chrono::duration<double> dt = clock_type::now() - t0;
+		best = std::min(best, dt.count());
+	}
+
+	return values / best / 1e6;
+}
+
+volatile uint32_t sink;
+
+} /* namespace */
+
+int main()
+{
+	constexpr size_t n = 4u << 20;
+	std::vector<stream> streams = {
+		/* steady cruise: 64 MHz capture of a 5 ms period, +-40 ticks */
+		walk("cruise", n, 320000, 40),
+		/* acceleration noise, +-2000 ticks */
+		walk("dynamic", n, 320000, 2000),
+		/* 48 MHz / 2049 capture, +-1 tick */
+		walk("coarse", n, 117, 1),
+		extremes(),
+	};
+	bool ok = true;
+
+	std::printf("%-10s %10s %8s %12s %12s %12s\n", "stream", "values",
+		    "B/value", "enc_Mv/s", "dec_Mv/s", "batch_Mv/s");
+
+	for (const auto &s : streams) {
+		auto coded = encode(s.periods);
+		std::vector<uint32_t> out(s.periods.size());
+
+		ok = check(s, coded) && ok;
+
+		double enc = mvalues_per_sec(s.periods.size(), [&] {
+			sink = static_cast<uint32_t>(encode(s.periods).size());
+		});
+		double dec = mvalues_per_sec(s.periods.size(), [&] {
+			pcodec_state st{};
+			size_t pos = 0;
+
+			for (size_t i = 0; i < out.size(); i++) {
+				pos += pcodec_decode(&st, &coded[pos],
+						     coded.size() - pos, &out[i]);
+			}
+			sink = out.back();
+		});
+		double batch = mvalues_per_sec(s.periods.size(), [&] {
+			pcodec_state st{};
+			size_t consumed;
+
+			pcodec_decode_batch(&st, coded.data(), coded.size(),
+					    out.data(), out.size(), &consumed);
+			sink = out.back();
+		});
+
+		std::printf("%-10s %10zu %8.3f %12.1f %12.1f %12.1f\n",
+			    s.name.c_str(), s.periods.size(),
+			    double(coded.size()) / s.periods.size(), enc, dec, batch);
+	}
+
+	std::printf("round-trip %s\n", ok ? "ok" : "FAILED");
+
+	return ok ? 0 : 1;
+}
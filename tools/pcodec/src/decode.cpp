@@ -0,0 +1,215 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Decode period streams captured from the board console, to CSV.
+ *
+ *   pcodec_decode telemetry <console.log>   "TLM ..." lines
+ *   pcodec_decode blackbox <console.log>    output of "bb dump"
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "period_codec_batch.hpp"
+
+namespace {
+
+/* Record header of app/src/blackbox.c. */
+struct bb_record {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t count;
+	uint32_t cycles_per_sec;
+	uint32_t len;
+	uint32_t reason;
+	uint32_t crc;
+};
+
+constexpr uint32_t bb_flash_magic = 0x42424c47U;
+
+uint32_t crc32_ieee(const uint8_t *d, size_t len)
+{
+	uint32_t crc = ~0U;
+
+	while (len--) {
+		crc ^= *d++;
+		for (int k = 0; k < 8; k++) {
+			crc = (crc >> 1) ^ (0xedb88320U & (0U - (crc & 1U)));
+		}
+	}
+
+	return ~crc;
+}
+
+bool parse_hex(const std::string &hex, std::vector<uint8_t> &out)
+{
+	if (hex.size() % 2 != 0) {
+		return false;
+	}
+	for (size_t i = 0; i < hex.size(); i += 2) {
+		char *end;
+		std::string byte = hex.substr(i, 2);
+
+		out.push_back(static_cast<uint8_t>(std::strtoul(byte.c_str(),
+								&end, 16)));
+		if (*end != '\0') {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Print input/output pairs, return false on a malformed payload. */
+bool print_pairs(const std::vector<uint8_t> &payload, const char *prefix,
+		 size_t expected)
+{
+	std::vector<int32_t> deltas(payload.size());
+	size_t consumed;
+	size_t n = pcodec_decode_deltas(payload.data(), payload.size(),
+					deltas.data(), deltas.size(), &consumed);
+	uint32_t in = 0, out = 0;
+
+	if (consumed != payload.size() || n % 2 != 0 ||
+	    (expected != 0 && n != 2 * expected)) {
+		return false;
+	}
+	for (size_t i = 0; i < n; i += 2) {
+		in += deltas[i];
+		out += deltas[i + 1];
+		std::printf("%s%zu,%u,%u\n", prefix, i / 2, in, out);
+	}
+
+	return true;
+}
+
+int telemetry(std::istream &in)
+{
+	std::string line;
+	unsigned long lost = 0;
+
+	std::printf("seq,index,in_cycles,out_cycles\n");
+	while (std::getline(in, line)) {
+		size_t pos = line.find("TLM ");
+
+		if (pos == std::string::npos) {
+			continue;
+		}
+
+		std::istringstream ss(line.substr(pos + 4));
+		std::string seq, hex;
+		unsigned long dropped;
+		std::vector<uint8_t> payload;
+
+		if (line.compare(pos + 4, 4, "cps=") == 0) {
+			std::printf("# cycles_per_sec %s\n", line.c_str() + pos + 8);
+			continue;
+		}
+		if (!(ss >> seq >> dropped) || !(ss >> hex) ||
+		    !parse_hex(hex, payload)) {
+			std::fprintf(stderr, "skipped malformed line: %s\n",
+				     line.c_str());
+			continue;
+		}
+
+		lost += dropped;
+		seq += ',';
+		if (!print_pairs(payload, seq.c_str(), 0)) {
+			std::fprintf(stderr, "frame %s: bad payload\n", seq.c_str());
+		}
+	}
+	if (lost) {
+		std::fprintf(stderr, "%lu samples dropped on the device\n", lost);
+	}
+
+	return 0;
+}
+
+/* "00000000: 47 4c 42 42 ... |GLBB....|" lines of shell_hexdump_line() */
+int blackbox(std::istream &in)
+{
+	std::vector<uint8_t> data;
+	std::string line;
+
+	while (std::getline(in, line)) {
+		size_t colon = line.find(": ");
+		size_t bar = line.find('|');
+
+		if (colon == std::string::npos || colon != 8) {
+			continue;
+		}
+
+		std::istringstream ss(line.substr(colon + 2, bar == std::string::npos ?
+						  std::string::npos :
+						  bar - colon - 2));
+		std::string byte;
+
+		while (ss >> byte) {
+			if (!parse_hex(byte, data)) {
+				break;
+			}
+		}
+	}
+
+	bb_record rec;
+
+	if (data.size() < sizeof(rec)) {
+		std::fprintf(stderr, "no record in input\n");
+		return 1;
+	}
+	std::memcpy(&rec, data.data(), sizeof(rec));
+	if (rec.magic != bb_flash_magic || data.size() < sizeof(rec) + rec.len) {
+		std::fprintf(stderr, "not a black-box record\n");
+		return 1;
+	}
+
+	std::vector<uint8_t> payload(data.begin() + sizeof(rec),
+				     data.begin() + sizeof(rec) + rec.len);
+
+	if (crc32_ieee(payload.data(), payload.size()) != rec.crc) {
+		std::fprintf(stderr, "CRC mismatch\n");
+		return 1;
+	}
+
+	std::printf("# cycles_per_sec %u, reason %d\n", rec.cycles_per_sec,
+		    (int32_t)rec.reason);
+	std::printf("index,in_cycles,out_cycles\n");
+	if (!print_pairs(payload, "", rec.count)) {
+		std::fprintf(stderr, "bad payload\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+	if (argc != 3) {
+		std::fprintf(stderr,
+			     "usage: pcodec_decode telemetry|blackbox <console.log>\n");
+		return 2;
+	}
+
+	std::ifstream in(argv[2]);
+	if (!in) {
+		std::fprintf(stderr, "%s: cannot open\n", argv[2]);
+		return 1;
+	}
+
+	if (std::strcmp(argv[1], "telemetry") == 0) {
+		return telemetry(in);
+	} else if (std::strcmp(argv[1], "blackbox") == 0) {
+		return blackbox(in);
+	}
+
+	std::fprintf(stderr, "unknown stream type %s\n", argv[1]);
+	return 2;
+}
@@ -0,0 +1,350 @@
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Edge stream injection and recording for the b500e Renode platform.
+//
+// B500E_EdgeInjector replays a Saleae Logic 2 CSV export (or a square
+// wave) on its GPIO outputs at the recorded virtual times. All outputs
+// carry the same signal, so one stream can feed both speed inputs.
+// B500E_EdgeRecorder timestamps the levels of its GPIO inputs and writes
+// them in the same CSV format, which the host tools read back. A square
+// wave frequency step and the recorded rising edges give the latency from
+// an input change to the output.
+//
+// Both sit on the system bus only to be registered; they have no
+// registers.
+//
+
+using System;
+using System.Collections.Generic;
+using System.Collections.ObjectModel;
+using System.Globalization;
+using System.IO;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Peripherals.Bus;
+using Antmicro.Renode.Time;
+
+namespace Antmicro.Renode.Peripherals.Miscellaneous
+{
+    public class B500E_EdgeInjector : IDoubleWordPeripheral, IKnownSize, INumberedGPIOOutput
+    {
+        public B500E_EdgeInjector(IMachine machine, int outputs = 2)
+        {
+            this.machine = machine;
+            var connections = new Dictionary<int, IGPIO>();
+            for(var i = 0; i < outputs; i++)
+            {
+                connections[i] = new GPIO();
+            }
+            Connections = new ReadOnlyDictionary<int, IGPIO>(connections);
+
+            timer = new LimitTimer(machine.ClockSource, TickHz, this, "edges", limit: 1,
+                                   direction: Direction.Ascending, workMode: WorkMode.OneShot, eventEnabled: true);
+            timer.LimitReached += OnEdge;
+        }
+
+        // Load the transitions of one column of a Logic 2 CSV export.
+        public void Load(string path, int column = 1)
+        {
+            var loaded = new List<Tuple<ulong, bool>>();
+            double? start = null;
+            bool? last = null;
+
+            foreach(var line in File.ReadLines(path))
+            {
+                var fields = line.Split(',');
+                if(fields.Length <= column ||
+                   !double.TryParse(fields[0], NumberStyles.Float, CultureInfo.InvariantCulture, out var time))
+                {
+                    continue;
+                }
+
+                var level = fields[column].Trim() != "0";
+                if(start == null)
+                {
+                    start = time;
+                }
+                if(level == last)
+                {
+                    continue;
+                }
+                last = level;
+                loaded.Add(Tuple.Create((ulong)Math.Round((time - start.Value) * TickHz), level));
+            }
+
+            steps = loaded;
+            squareHigh = 0;
+        }
+
+        // Play a square wave instead, until stopped.
+        public void Square(double frequency, double duty = 0.5)
+        {
+            squareHigh = Math.Max(1, (ulong)Math.Round(duty * TickHz / frequency));
+            squareLow = Math.Max(1, (ulong)Math.Round((1 - duty) * TickHz / frequency));
+            steps = null;
+            stepHigh = 0;
+            StepCaptureTime = -1;
+        }
+
+        // Switch the square wave to another frequency at its next rising edge.
+        public void Step(double frequency, double duty = 0.5)
+        {
+            stepHigh = Math.Max(1, (ulong)Math.Round(duty * TickHz / frequency));
+            stepLow = Math.Max(1, (ulong)Math.Round((1 - duty) * TickHz / frequency));
+            stepRises = 0;
+            StepCaptureTime = -1;
+        }
+
+        public void Start()
+        {
+            Stop();
+            index = 0;
+            if(squareHigh != 0)
+            {
+                level = false;
+                Arm(squareLow);
+            }
+            else if(steps != null && steps.Count > 0)
+            {
+                Arm(steps[0].Item1);
+            }
+        }
+
+        public void Stop()
+        {
+            timer.Enabled = false;
+        }
+
+        public void Reset()
+        {
+            Stop();
+            Edges = 0;
+            SetOutputs(false);
+        }
+
+        public uint ReadDoubleWord(long offset)
+        {
+            return 0;
+        }
+
+        public void WriteDoubleWord(long offset, uint value)
+        {
+        }
+
+        public ulong Edges { get; private set; }
+
+        // Virtual time of the rising edge that ends the first period after
+        // the last Step(), i.e. the first capture of the new period, in
+        // seconds; -1 until then.
+        public double StepCaptureTime { get; private set; } = -1;
+
+        public IReadOnlyDictionary<int, IGPIO> Connections { get; }
+
+        public long Size => 0x10;
+
+        private void OnEdge()
+        {
+            if(squareHigh != 0)
+            {
+                SetOutputs(!level);
+                if(level && stepHigh != 0)
+                {
+                    OnStepRise();
+                }
+                Arm(level ? squareHigh : squareLow);
+                return;
+            }
+
+            SetOutputs(steps[index].Item2);
+            if(++index < steps.Count)
+            {
+                Arm(steps[index].Item1 - steps[index - 1].Item1);
+            }
+        }
+
+        private void OnStepRise()
+        {
+            if(stepRises++ == 0)
+            {
+                // this edge starts the first period at the new frequency
+                squareHigh = stepHigh;
+                squareLow = stepLow;
+                return;
+            }
+            StepCaptureTime = machine.LocalTimeSource.ElapsedVirtualTime.TotalSeconds;
+            stepHigh = 0;
+        }
+
+        private void Arm(ulong ticks)
+        {
+            if(ticks == 0)
+            {
+                OnEdge();
+                return;
+            }
+            timer.Limit = ticks;
+            timer.ResetValue();
+            timer.Enabled = true;
+        }
+
+        private void SetOutputs(bool value)
+        {
+            if(value != level)
+            {
+                Edges++;
+            }
+            level = value;
+            foreach(var output in Connections.Values)
+            {
+                output.Set(value);
+            }
+        }
+
+        private List<Tuple<ulong, bool>> steps;
+        private ulong squareHigh, squareLow;
+        private ulong stepHigh, stepLow;
+        private int stepRises;
+        private int index;
+        private bool level;
+        private readonly IMachine machine;
+        private readonly LimitTimer timer;
+
+        // 10 ns resolution
+        private const long TickHz = 100000000;
+    }
+
+    public class B500E_EdgeRecorder : IDoubleWordPeripheral, IKnownSize, IGPIOReceiver
+    {
+        public B500E_EdgeRecorder(IMachine machine, int inputs = 2)
+        {
+            this.machine = machine;
+            levels = new bool[inputs];
+            edges = new ulong[inputs];
+            lastRise = new double[inputs];
+            period = new double[inputs];
+            rises = new List<double>[inputs];
+            for(var i = 0; i < inputs; i++)
+            {
+                rises[i] = new List<double>();
+            }
+            Reset();
+        }
+
+        // Write every level change to a Logic 2 style CSV file.
+        public void Record(string path)
+        {
+            Stop();
+            writer = new StreamWriter(path);
+            writer.Write("Time [s]");
+            for(var i = 0; i < levels.Length; i++)
+            {
+                writer.Write(",Channel {0}", i);
+            }
+            writer.WriteLine();
+            WriteLevels(Now);
+        }
+
+        public void Stop()
+        {
+            writer?.Dispose();
+            writer = null;
+        }
+
+        // Rising edges seen on an input.
+        public ulong Edges(int input)
+        {
+            return edges[input];
+        }
+
+        // Last rising to rising edge interval of an input, in usec.
+        public double PeriodUs(int input)
+        {
+            return period[input] * 1e6;
+        }
+
+        // Time from since (seconds) to the first rising edge of an input
+        // that starts a period within toleranceUs of periodUs, in usec; -1
+        // if no such period was recorded yet.
+        public double LatencyUs(int input, double since, double periodUs, double toleranceUs)
+        {
+            var times = rises[input];
+            for(var i = 0; i + 1 < times.Count; i++)
+            {
+                if(times[i] >= since &&
+                   Math.Abs((times[i + 1] - times[i]) * 1e6 - periodUs) <= toleranceUs)
+                {
+                    return (times[i] - since) * 1e6;
+                }
+            }
+            return -1;
+        }
+
+        public void OnGPIO(int number, bool value)
+        {
+            if(number < 0 || number >= levels.Length || levels[number] == value)
+            {
+                return;
+            }
+
+            var now = Now;
+            levels[number] = value;
+            if(value)
+            {
+                if(edges[number]++ != 0)
+                {
+                    period[number] = now - lastRise[number];
+                }
+                lastRise[number] = now;
+                rises[number].Add(now);
+            }
+            WriteLevels(now);
+        }
+
+        public void Reset()
+        {
+            Stop();
+            for(var i = 0; i < levels.Length; i++)
+            {
+                levels[i] = false;
+                edges[i] = 0;
+                period[i] = 0;
+                rises[i].Clear();
+            }
+        }
+
+        public uint ReadDoubleWord(long offset)
+        {
+            return 0;
+        }
+
+        public void WriteDoubleWord(long offset, uint value)
+        {
+        }
+
+        public long Size => 0x10;
+
+        private void WriteLevels(double time)
+        {
+            if(writer == null)
+            {
+                return;
+            }
+            writer.Write(time.ToString("F9", CultureInfo.InvariantCulture));
+            foreach(var level in levels)
+            {
+                writer.Write(level ? ",1" : ",0");
+            }
+            writer.WriteLine();
+        }
+
+        private double Now => machine.LocalTimeSource.ElapsedVirtualTime.TotalSeconds;
+
+        private readonly IMachine machine;
+        private readonly bool[] levels;
+        private readonly ulong[] edges;
+        private readonly double[] lastRise;
+        private readonly double[] period;
+        private readonly List<double>[] rises;
+        private StreamWriter writer;
+    }
+}
@@ -0,0 +1,457 @@
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// STM32 timer with input capture and output compare for the b500e Renode
+// platform. The stock STM32_Timer model only counts and raises update
+// interrupts, while the IC and PWM drivers of the firmware also need:
+//  - input capture of the TIx edges fed to GPIO inputs 0..3, with direct
+//    and indirect mapping, polarity, input prescaler and overcapture;
+//  - slave reset mode on TI1FP1/TI2FP2, used by the PWM capture;
+//  - output compare (frozen, active/inactive on match, toggle, forced,
+//    PWM 1/2) driving GPIO outputs 0..3.
+// Preload registers, DMA requests, break and encoder modes are not
+// modelled: writes take effect at once.
+//
+
+using System.Collections.Generic;
+using System.Collections.ObjectModel;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Logging;
+using Antmicro.Renode.Peripherals.Bus;
+using Antmicro.Renode.Time;
+
+namespace Antmicro.Renode.Peripherals.Timers
+{
+    public class B500E_Timer : IDoubleWordPeripheral, IKnownSize, IGPIOReceiver, INumberedGPIOOutput
+    {
+        public B500E_Timer(IMachine machine, long frequency, bool is32Bit = false, bool splitInterrupts = false, int channels = 4)
+        {
+            this.channels = channels;
+            this.splitInterrupts = splitInterrupts;
+            mask = is32Bit ? uint.MaxValue : 0xFFFFu;
+
+            IRQ = new GPIO();
+            CCIRQ = new GPIO();
+            var outputs = new Dictionary<int, IGPIO>();
+            for(var i = 0; i < channels; i++)
+            {
+                outputs[i] = new GPIO();
+            }
+            Connections = new ReadOnlyDictionary<int, IGPIO>(outputs);
+
+            counter = new LimitTimer(machine.ClockSource, frequency, this, "counter", limit: (ulong)mask + 1,
+                                     direction: Direction.Ascending, workMode: WorkMode.Periodic, eventEnabled: true);
+            counter.LimitReached += OnUpdate;
+
+            match = new LimitTimer[channels];
+            for(var i = 0; i < channels; i++)
+            {
+                var ch = i;
+                match[i] = new LimitTimer(machine.ClockSource, frequency, this, "match" + i, limit: 1,
+                                          direction: Direction.Ascending, workMode: WorkMode.OneShot, eventEnabled: true);
+                match[i].LimitReached += () => OnMatch(ch);
+            }
+
+            ccr = new uint[channels];
+            events = new uint[channels];
+            inputs = new bool[channels];
+            levels = new bool[channels];
+            Reset();
+        }
+
+        public void Reset()
+        {
+            lock(locker)
+            {
+                cr1 = smcr = dier = sr = ccer = psc = 0;
+                ccmr[0] = ccmr[1] = 0;
+                arr = mask;
+                other.Clear();
+                counter.Reset();
+                counter.Limit = (ulong)mask + 1;
+                for(var ch = 0; ch < channels; ch++)
+                {
+                    match[ch].Reset();
+                    ccr[ch] = events[ch] = 0;
+                    inputs[ch] = levels[ch] = false;
+                    Connections[ch].Unset();
+                }
+                IRQ.Unset();
+                CCIRQ.Unset();
+            }
+        }
+
+        public uint ReadDoubleWord(long offset)
+        {
+            lock(locker)
+            {
+                switch((Register)offset)
+                {
+                case Register.CR1: return cr1;
+                case Register.SMCR: return smcr;
+                case Register.DIER: return dier;
+                case Register.SR: return sr;
+                case Register.EGR: return 0;
+                case Register.CCMR1: return ccmr[0];
+                case Register.CCMR2: return ccmr[1];
+                case Register.CCER: return ccer;
+                case Register.CNT: return (uint)counter.Value;
+                case Register.PSC: return psc;
+                case Register.ARR: return arr;
+                case Register.CCR1:
+                case Register.CCR2:
+                case Register.CCR3:
+                case Register.CCR4:
+                    var index = (int)(offset - (long)Register.CCR1) / 4;
+                    return index < channels ? ccr[index] : 0;
+                default:
+                    return other.TryGetValue(offset, out var value) ? value : 0;
+                }
+            }
+        }
+
+        public void WriteDoubleWord(long offset, uint value)
+        {
+            lock(locker)
+            {
+                switch((Register)offset)
+                {
+                case Register.CR1:
+                    cr1 = value;
+                    counter.Enabled = (value & CR1_CEN) != 0;
+                    RescheduleAll();
+                    break;
+                case Register.SMCR:
+                    smcr = value;
+                    break;
+                case Register.DIER:
+                    dier = value;
+                    break;
+                case Register.SR:
+                    sr &= value;
+                    break;
+                case Register.EGR:
+                    if((value & SR_UIF) != 0)
+                    {
+                        RestartPeriod();
+                    }
+                    for(var ch = 0; ch < channels; ch++)
+                    {
+                        if((value & CCIF(ch)) != 0)
+                        {
+                            Capture(ch);
+                        }
+                    }
+                    break;
+                case Register.CCMR1:
+                case Register.CCMR2:
+                    ccmr[(offset - (long)Register.CCMR1) / 4] = value;
+                    ApplyForcedLevels();
+                    RescheduleAll();
+                    break;
+                case Register.CCER:
+                    for(var ch = 0; ch < channels; ch++)
+                    {
+                        if(!ChannelEnabled(ch))
+                        {
+                            events[ch] = 0;
+                        }
+                    }
+                    ccer = value;
+                    for(var ch = 0; ch < channels; ch++)
+                    {
+                        RefreshOutput(ch);
+                    }
+                    break;
+                case Register.CNT:
+                    counter.Value = value & mask;
+                    RescheduleAll();
+                    break;
+                case Register.PSC:
+                    psc = value & 0xFFFF;
+                    counter.Divider = (int)psc + 1;
+                    RescheduleAll();
+                    break;
+                case Register.ARR:
+                    arr = value & mask;
+                    counter.Limit = (ulong)arr + 1;
+                    RescheduleAll();
+                    break;
+                case Register.CCR1:
+                case Register.CCR2:
+                case Register.CCR3:
+                case Register.CCR4:
+                    var index = (int)(offset - (long)Register.CCR1) / 4;
+                    if(index < channels)
+                    {
+                        ccr[index] = value & mask;
+                        Reschedule(index);
+                    }
+                    break;
+                default:
+                    other[offset] = value;
+                    break;
+                }
+                UpdateInterrupts();
+            }
+        }
+
+        // Edge on TI(number + 1).
+        public void OnGPIO(int number, bool value)
+        {
+            if(number < 0 || number >= channels)
+            {
+                this.Log(LogLevel.Warning, "No timer input {0}", number);
+                return;
+            }
+
+            lock(locker)
+            {
+                if(inputs[number] == value)
+                {
+                    return;
+                }
+                inputs[number] = value;
+
+                for(var ch = 0; ch < channels; ch++)
+                {
+                    var source = CaptureSelection(ch) == 1 ? ch : CaptureSelection(ch) == 2 ? (ch ^ 1) : -1;
+
+                    if(source != number || !ChannelEnabled(ch) || !EdgeMatches(ch, value))
+                    {
+                        continue;
+                    }
+                    if(++events[ch] < (1u << InputPrescaler(ch)))
+                    {
+                        continue;
+                    }
+                    events[ch] = 0;
+                    Capture(ch);
+                }
+
+                // slave reset mode, triggered by TI1FP1 or TI2FP2
+                var sms = (smcr & 7) | ((smcr >> 13) & 8);
+                var ts = (smcr >> 4) & 7;
+                if(sms == 4 && ((ts == 5 && number == 0) || (ts == 6 && number == 1)) && EdgeMatches(number, value))
+                {
+                    RestartPeriod();
+                }
+
+                UpdateInterrupts();
+            }
+        }
+
+        public GPIO IRQ { get; }
+
+        // Capture/compare interrupt of advanced timers, see splitInterrupts.
+        public GPIO CCIRQ { get; }
+
+        public IReadOnlyDictionary<int, IGPIO> Connections { get; }
+
+        public long Size => 0x400;
+
+        private void Capture(int ch)
+        {
+            if((sr & CCIF(ch)) != 0)
+            {
+                sr |= CCOF(ch);
+            }
+            if(CaptureSelection(ch) != 0)
+            {
+                ccr[ch] = (uint)counter.Value;
+            }
+            sr |= CCIF(ch);
+        }
+
+        private void RestartPeriod()
+        {
+            counter.Value = 0;
+            if((cr1 & CR1_URS) == 0)
+            {
+                sr |= SR_UIF;
+            }
+            StartPwmPeriod();
+            RescheduleAll();
+        }
+
+        private void OnUpdate()
+        {
+            lock(locker)
+            {
+                if((cr1 & CR1_UDIS) == 0)
+                {
+                    sr |= SR_UIF;
+                }
+                StartPwmPeriod();
+                UpdateInterrupts();
+            }
+        }
+
+        private void OnMatch(int ch)
+        {
+            lock(locker)
+            {
+                sr |= CCIF(ch);
+                switch(OutputMode(ch))
+                {
+                case 1: SetLevel(ch, true); break;
+                case 2: SetLevel(ch, false); break;
+                case 3: SetLevel(ch, !levels[ch]); break;
+                case 6: SetLevel(ch, false); break;
+                case 7: SetLevel(ch, true); break;
+                }
+                Reschedule(ch);
+                UpdateInterrupts();
+            }
+        }
+
+        private void StartPwmPeriod()
+        {
+            for(var ch = 0; ch < channels; ch++)
+            {
+                if(CaptureSelection(ch) != 0)
+                {
+                    continue;
+                }
+                if(OutputMode(ch) == 6)
+                {
+                    SetLevel(ch, ccr[ch] != 0);
+                }
+                else if(OutputMode(ch) == 7)
+                {
+                    SetLevel(ch, ccr[ch] == 0);
+                }
+            }
+        }
+
+        private void ApplyForcedLevels()
+        {
+            for(var ch = 0; ch < channels; ch++)
+            {
+                if(CaptureSelection(ch) != 0)
+                {
+                    continue;
+                }
+                if(OutputMode(ch) == 4)
+                {
+                    SetLevel(ch, false);
+                }
+                else if(OutputMode(ch) == 5)
+                {
+                    SetLevel(ch, true);
+                }
+            }
+        }
+
+        private void RescheduleAll()
+        {
+            for(var ch = 0; ch < channels; ch++)
+            {
+                Reschedule(ch);
+            }
+        }
+
+        // Arm the next compare match of an output channel.
+        private void Reschedule(int ch)
+        {
+            match[ch].Enabled = false;
+            if(!counter.Enabled || CaptureSelection(ch) != 0 || ccr[ch] > arr ||
+               (OutputMode(ch) == 0 && (dier & CCIF(ch)) == 0))
+            {
+                return;
+            }
+
+            var period = (ulong)arr + 1;
+            var now = counter.Value;
+            var delta = ccr[ch] > now ? ccr[ch] - now : period - now + ccr[ch];
+
+            match[ch].Divider = counter.Divider;
+            match[ch].Limit = delta == 0 ? period : delta;
+            match[ch].ResetValue();
+            match[ch].Enabled = true;
+        }
+
+        private void SetLevel(int ch, bool level)
+        {
+            levels[ch] = level;
+            RefreshOutput(ch);
+        }
+
+        private void RefreshOutput(int ch)
+        {
+            var inverted = ((ccer >> (4 * ch + 1)) & 1) != 0;
+
+            Connections[ch].Set(CaptureSelection(ch) == 0 && ChannelEnabled(ch) && (levels[ch] ^ inverted));
+        }
+
+        private void UpdateInterrupts()
+        {
+            var pending = sr & dier;
+            const uint ccFlags = 0x1Eu;
+
+            if(splitInterrupts)
+            {
+                IRQ.Set((pending & ~ccFlags & 0x5Fu) != 0);
+                CCIRQ.Set((pending & ccFlags) != 0);
+            }
+            else
+            {
+                IRQ.Set((pending & 0x5Fu) != 0);
+            }
+        }
+
+        private bool EdgeMatches(int ch, bool rising)
+        {
+            var p = ((ccer >> (4 * ch + 1)) & 1) != 0;
+            var np = ((ccer >> (4 * ch + 3)) & 1) != 0;
+
+            return (p && np) || (p != rising);
+        }
+
+        private uint Ccmr(int ch) => (ccmr[ch / 2] >> (8 * (ch % 2))) & 0xFF;
+        private uint CaptureSelection(int ch) => Ccmr(ch) & 3;
+        private int InputPrescaler(int ch) => (int)((Ccmr(ch) >> 2) & 3);
+        private uint OutputMode(int ch) => (Ccmr(ch) >> 4) & 7;
+        private bool ChannelEnabled(int ch) => ((ccer >> (4 * ch)) & 1) != 0;
+        private static uint CCIF(int ch) => 1u << (ch + 1);
+        private static uint CCOF(int ch) => 1u << (ch + 9);
+
+        private uint cr1, smcr, dier, sr, ccer, psc, arr;
+        private readonly uint[] ccmr = new uint[2];
+        private readonly uint[] ccr;
+        private readonly uint[] events;
+        private readonly bool[] inputs;
+        private readonly bool[] levels;
+        private readonly Dictionary<long, uint> other = new Dictionary<long, uint>();
+        private readonly LimitTimer counter;
+        private readonly LimitTimer[] match;
+        private readonly int channels;
+        private readonly bool splitInterrupts;
+        private readonly uint mask;
+        private readonly object locker = new object();
+
+        private const uint CR1_CEN = 1u << 0;
+        private const uint CR1_UDIS = 1u << 1;
+        private const uint CR1_URS = 1u << 2;
+        private const uint SR_UIF = 1u << 0;
+
+        private enum Register : long
+        {
+            CR1 = 0x00,
+            SMCR = 0x08,
+            DIER = 0x0C,
+            SR = 0x10,
+            EGR = 0x14,
+            CCMR1 = 0x18,
+            CCMR2 = 0x1C,
+            CCER = 0x20,
+            CNT = 0x24,
+            PSC = 0x28,
+            ARR = 0x2C,
+            CCR1 = 0x34,
+            CCR2 = 0x38,
+            CCR3 = 0x3C,
+            CCR4 = 0x40,
+        }
+    }
+}
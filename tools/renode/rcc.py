@@ -0,0 +1,32 @@
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# STM32C0 RCC for the b500e Renode platform: registers read back as
+# written, with the ready and status bits following their enable and
+# select bits so that the clock setup of the firmware completes.
+#
+
+if request.isInit:
+    # CR: HSION and HSIRDY set, HSIDIV /4 (12 MHz) out of reset
+    regs = {0x00: 0x00001540}
+elif request.isRead:
+    value = regs.get(request.offset, 0)
+    if request.offset == 0x00:
+        # CR: HSIRDY follows HSION, HSERDY follows HSEON
+        value &= ~((1 << 10) | (1 << 17))
+        if value & (1 << 8):
+            value |= 1 << 10
+        if value & (1 << 16):
+            value |= 1 << 17
+    elif request.offset == 0x08:
+        # CFGR: SWS follows SW
+        value = (value & ~0x38) | ((value & 0x7) << 3)
+    elif request.offset == 0x5C:
+        # CSR1: LSERDY follows LSEON
+        value = (value & ~0x2) | ((value & 0x1) << 1)
+    elif request.offset == 0x60:
+        # CSR2: LSIRDY follows LSION
+        value = (value & ~0x2) | ((value & 0x1) << 1)
+    request.value = value
+elif request.isWrite:
+    regs[request.offset] = request.value
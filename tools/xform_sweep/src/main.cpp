@@ -0,0 +1,275 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Parameter sweep of the firmware speed transform (lib/speedxform).
+ *
+ * Replays the edges of Saleae Logic 2 exports through every combination of
+ * the requested parameter ranges, in parallel, and ranks them by error,
+ * jitter and latency against the ideal scaled output.
+ *
+ *   xform_sweep [options] <export.csv|digital_N.bin>...
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "saleae_export.hpp"
+#include "pool.hpp"
+#include "sweep.hpp"
+
+namespace {
+
+struct range {
+	long first;
+	long last;
+	long step;
+
+	std::vector<long> values() const
+	{
+		std::vector<long> v;
+
+		for (long x = first; x <= last; x += step) {
+			v.push_back(x);
+		}
+
+		return v;
+	}
+};
+
+struct result {
+	xform_params params;
+	metrics m;
+};
+
+/* "a", "a:b" or "a:b:step" */
+range parse_range(const std::string &s)
+{
+	range r{};
+	char *end;
+
+	r.first = std::strtol(s.c_str(), &end, 0);
+	r.last = r.first;
+	r.step = 1;
+	if (*end == ':') {
+		r.last = std::strtol(end + 1, &end, 0);
+	}
+	if (*end == ':') {
+		r.step = std::strtol(end + 1, &end, 0);
+	}
+	if (*end != '\0' || r.step <= 0 || r.last < r.first) {
+		throw std::invalid_argument("bad range: " + s);
+	}
+
+	return r;
+}
+
+void usage(const char *name)
+{
+	std::fprintf(stderr,
+		"usage: %s [options] <export.csv|digital_N.bin>...\n"
+		"  --channel NAME|IDX  CSV column (default 0)\n"
+		"  --clock HZ          capture timer clock (default 64000000)\n"
+		"  --ratio NUM/DEN     output/input period ratio (default 2/1)\n"
+		"  --window R          moving average length (default 1:8)\n"
+		"  --window-ms R       moving average time span, replaces\n"
+		"                      --window when not 0 (default 0)\n"
+		"  --hysteresis R      hysteresis in ppm (default 0:5000:500)\n"
+		"  --gain R            predictor gain, 1/256 (default 0:256:32)\n"
+		"  --weights E,J,L     error, jitter, latency weights\n"
+		"  --threads N         worker threads (default: all cores)\n"
+		"  --top N             ranked results shown (default 10)\n"
+		"  --csv FILE          write every result\n"
+		"ranges are VALUE, FIRST:LAST or FIRST:LAST:STEP\n", name);
+}
+
+} /* namespace */
+
+int main(int argc, char **argv)
+{
+	std::string channel = "0";
+	double clock_hz = 64e6;
+	unsigned long ratio_num = 2, ratio_den = 1;
+	range window{1, 8, 1};
+	range window_ms{0, 0, 1};
+	range hysteresis{0, 5000, 500};
+	range gain{0, 256, 32};
+	weights w;
+	unsigned threads = std::thread::hardware_concurrency();
+	size_t top = 10;
+	std::string csv;
+	std::vector<std::string> inputs;
+
+	try {
+		for (int i = 1; i < argc; i++) {
+			std::string arg = argv[i];
+			auto next = [&]() -> std::string {
+				if (i + 1 >= argc) {
+					throw std::invalid_argument(arg + " needs a value");
+				}
+				return argv[++i];
+			};
+
+			if (arg == "--channel") {
+				channel = next();
+			} else if (arg == "--clock") {
+				clock_hz = std::stod(next());
+			} else if (arg == "--ratio") {
+				std::string v = next();
+				if (std::sscanf(v.c_str(), "%lu/%lu", &ratio_num,
+						&ratio_den) != 2 || ratio_den == 0) {
+					throw std::invalid_argument("bad ratio: " + v);
+				}
+			} else if (arg == "--window") {
+				window = parse_range(next());
+			} else if (arg == "--window-ms") {
+				window_ms = parse_range(next());
+			} else if (arg == "--hysteresis") {
+				hysteresis = parse_range(next());
+			} else if (arg == "--gain") {
+				gain = parse_range(next());
+			} else if (arg == "--weights") {
+				std::string v = next();
+				if (std::sscanf(v.c_str(), "%lf,%lf,%lf", &w.error,
+						&w.jitter, &w.latency) != 3) {
+					throw std::invalid_argument("bad weights: " + v);
+				}
+			} else if (arg == "--threads") {
+				threads = std::stoul(next());
+			} else if (arg == "--top") {
+				top = std::stoul(next());
+			} else if (arg == "--csv") {
+				csv = next();
+			} else if (arg == "-h" || arg == "--help") {
+				usage(argv[0]);
+				return 0;
+			} else if (arg.rfind("--", 0) == 0) {
+				throw std::invalid_argument("unknown option " + arg);
+			} else {
+				inputs.push_back(arg);
+			}
+		}
+		if (inputs.empty()) {
+			usage(argv[0]);
+			return 2;
+		}
+		if (window.first < 1 || window.last > (long)XFORM_WINDOW_MAX ||
+		    window_ms.first < 0 || hysteresis.first < 0) {
+			throw std::invalid_argument("window or hysteresis out of range");
+		}
+	} catch (const std::exception &e) {
+		std::fprintf(stderr, "%s\n", e.what());
+		return 2;
+	}
+
+	std::vector<replay> replays;
+
+	try {
+		for (const auto &path : inputs) {
+			replays.push_back(make_replay(read_rising_edges(path, channel),
+						      clock_hz));
+			std::fprintf(stderr, "%s: %zu periods\n", path.c_str(),
+				     replays.back().periods.size());
+		}
+	} catch (const std::exception &e) {
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+
+	std::vector<result> results;
+
+	for (long ms : window_ms.values()) {
+		/* a time window makes the length irrelevant */
+		for (long win : (ms == 0) ? window.values() : std::vector<long>{1}) {
+			for (long hyst : hysteresis.values()) {
+				for (long g : gain.values()) {
+					xform_params p{};
+
+					p.ratio_num = ratio_num;
+					p.ratio_den = ratio_den;
+					p.window = win;
+					p.window_cycles = (uint32_t)(ms * clock_hz / 1000.0);
+					p.hysteresis_ppm = hyst;
+					p.gain = g;
+					results.push_back({p, {}});
+				}
+			}
+		}
+	}
+
+	{
+		/* chunks small enough for stealing to balance the load */
+		constexpr size_t chunk = 16;
+		work_stealing_pool pool(threads);
+
+		std::fprintf(stderr, "%zu combinations on %u threads\n",
+			     results.size(), pool.size());
+
+		for (size_t first = 0; first < results.size(); first += chunk) {
+			pool.submit([&, first] {
+				size_t last = std::min(first + chunk, results.size());
+
+				for (size_t i = first; i < last; i++) {
+					metrics sum{};
+
+					for (const auto &r : replays) {
+						metrics m = evaluate(r, results[i].params, w);
+
+						sum.error += m.error;
+						sum.jitter += m.jitter;
+						sum.latency += m.latency;
+						sum.score += m.score;
+					}
+					sum.error /= replays.size();
+					sum.jitter /= replays.size();
+					sum.latency /= replays.size();
+					sum.score /= replays.size();
+					results[i].m = sum;
+				}
+			});
+		}
+		pool.wait();
+	}
+
+	std::sort(results.begin(), results.end(),
+		  [](const result &a, const result &b) {
+			  return a.m.score < b.m.score;
+		  });
+
+	std::printf("%4s %6s %9s %10s %6s %10s %10s %10s %10s\n", "rank",
+		    "window", "window_ms", "hyst_ppm", "gain", "error_%",
+		    "jitter_%", "latency_ms", "score");
+	for (size_t i = 0; i < std::min(top, results.size()); i++) {
+		const auto &r = results[i];
+
+		std::printf("%4zu %6u %9.1f %10u %6d %10.4f %10.4f %10.3f %10.4f\n",
+			    i + 1, r.params.window,
+			    r.params.window_cycles * 1000.0 / clock_hz,
+			    r.params.hysteresis_ppm, r.params.gain, r.m.error,
+			    r.m.jitter, r.m.latency, r.m.score);
+	}
+
+	if (!csv.empty()) {
+		std::ofstream out(csv);
+
+		out << "window,window_ms,hysteresis_ppm,gain,error_pct,"
+		       "jitter_pct,latency_ms,score\n";
+		for (const auto &r : results) {
+			out << r.params.window << ','
+			    << r.params.window_cycles * 1000.0 / clock_hz << ','
+			    << r.params.hysteresis_ppm
+			    << ',' << r.params.gain << ',' << r.m.error << ','
+			    << r.m.jitter << ',' << r.m.latency << ','
+			    << r.m.score << '\n';
+		}
+	}
+
+	return 0;
+}
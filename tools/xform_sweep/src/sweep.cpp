@@ -0,0 +1,103 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "sweep.hpp"
+
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/* Longest output delay looked for, in input periods. */
+constexpr size_t max_lag = 32;
+
+} /* namespace */
+
+replay make_replay(const std::vector<double> &edges, double clock_hz)
+{
+	replay r{};
+	uint64_t last = 0;
+
+	for (size_t i = 0; i < edges.size(); i++) {
+		auto now = static_cast<uint64_t>(std::llround(edges[i] * clock_hz));
+
+		if (i > 0 && now > last) {
+			uint64_t period = now - last;
+
+			r.periods.push_back(period > UINT32_MAX ?
+					    UINT32_MAX : static_cast<uint32_t>(period));
+		}
+		last = now;
+	}
+
+	if (edges.size() > 1) {
+		r.mean_period = (edges.back() - edges.front()) /
+				static_cast<double>(edges.size() - 1);
+	}
+
+	return r;
+}
+
+metrics evaluate(const replay &r, const xform_params &p, const weights &w)
+{
+	const double ratio = static_cast<double>(p.ratio_num) / p.ratio_den;
+	const size_t n = r.periods.size();
+	std::vector<double> out(n);
+	xform_state st{};
+	metrics m{};
+
+	if (n < max_lag + 2) {
+		m.score = std::numeric_limits<double>::infinity();
+		return m;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		out[i] = xform_step(&p, &st, r.periods[i]);
+	}
+
+	/*
+	 * Output i is live during input period i + 1: that period, scaled, is
+	 * the ideal output. The lag best matching the output gives the latency.
+	 */
+	double best = std::numeric_limits<double>::infinity();
+	size_t best_lag = 0;
+
+	for (size_t lag = 0; lag <= max_lag; lag++) {
+		double sum = 0.0;
+
+		for (size_t i = lag; i + 1 < n; i++) {
+			double ideal = ratio * r.periods[i + 1 - lag];
+			double e = (out[i] - ideal) / ideal;
+
+			sum += e * e;
+		}
+		sum /= static_cast<double>(n - 1 - lag);
+		if (sum < best) {
+			best = sum;
+			best_lag = lag;
+		}
+	}
+
+	double err = 0.0;
+	double jit = 0.0;
+
+	for (size_t i = 1; i + 1 < n; i++) {
+		double ideal = ratio * r.periods[i + 1];
+		double prev_ideal = ratio * r.periods[i];
+		double e = (out[i] - ideal) / ideal;
+		double j = (out[i] - out[i - 1]) / out[i - 1] -
+			   (ideal - prev_ideal) / prev_ideal;
+
+		err += e * e;
+		jit += j * j;
+	}
+
+	m.error = 100.0 * std::sqrt(err / static_cast<double>(n - 2));
+	m.jitter = 100.0 * std::sqrt(jit / static_cast<double>(n - 2));
+	m.latency = 1000.0 * static_cast<double>(best_lag) * r.mean_period;
+	m.score = w.error * m.error + w.jitter * m.jitter +
+		  w.latency * m.latency;
+
+	return m;
+}
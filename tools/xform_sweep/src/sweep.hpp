@@ -0,0 +1,49 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef XFORM_SWEEP_SWEEP_HPP_
+#define XFORM_SWEEP_SWEEP_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include <speedxform/xform.h>
+
+/** Input periods as seen by the capture timer. */
+struct replay {
+	std::vector<uint32_t> periods;
+	/** Mean input period (s). */
+	double mean_period;
+};
+
+/** Quality of a parameter set, lower is better. */
+struct metrics {
+	/** RMS error against the ideal scaled period (%). */
+	double error;
+	/** RMS of the output changes not explained by the input (%). */
+	double jitter;
+	/** Delay of the output behind the input (ms). */
+	double latency;
+	/** Weighted sum of the above. */
+	double score;
+};
+
+struct weights {
+	double error = 1.0;
+	double jitter = 1.0;
+	double latency = 0.1;
+};
+
+/**
+ * Quantize rising edge times to capture timer periods.
+ *
+ * @param edges Rising edge times (s).
+ * @param clock_hz Capture timer clock.
+ */
+replay make_replay(const std::vector<double> &edges, double clock_hz);
+
+/** Run the firmware transform over @p r and score its output. */
+metrics evaluate(const replay &r, const xform_params &p, const weights &w);
+
+#endif /* XFORM_SWEEP_SWEEP_HPP_ */